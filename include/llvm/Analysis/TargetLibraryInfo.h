@@ -917,6 +917,8 @@ public:
 
   TargetLibraryInfo &getTLI() { return TLI; }
   const TargetLibraryInfo &getTLI() const { return TLI; }
+
+  Pass *createReplica() const override;
 };
 
 } // end namespace llvm
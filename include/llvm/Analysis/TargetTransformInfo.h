@@ -831,6 +831,8 @@ public:
   explicit TargetTransformInfoWrapperPass(TargetIRAnalysis TIRA);
 
   TargetTransformInfo &getTTI(Function &F);
+
+  Pass *createReplica() const override;
 };
 
 /// \brief Create an analysis pass wrapper around a TTI object.
@@ -207,6 +207,18 @@ FunctionSections("function-sections",
                  cl::desc("Emit functions into separate sections"),
                  cl::init(false));
 
+cl::opt<bool>
+ParallelObjectWriting("parallel-object-writing",
+                      cl::desc("Write object file sections on several threads "
+                               "(holds the whole object file in memory)"),
+                      cl::init(false));
+
+cl::opt<bool>
+FastStringTables("fast-string-tables",
+                 cl::desc("Don't merge string suffixes in object file string "
+                          "tables (faster, but the tables are larger)"),
+                 cl::init(false));
+
 cl::opt<bool> UniqueSectionNames("unique-section-names",
                                  cl::desc("Give unique names to every section"),
                                  cl::init(true));
@@ -289,6 +301,8 @@ static inline TargetOptions InitTargetOptionsFromCodeGenFlags() {
   Options.DataSections = DataSections;
   Options.FunctionSections = FunctionSections;
   Options.UniqueSectionNames = UniqueSectionNames;
+  Options.ParallelObjectWriting = ParallelObjectWriting;
+  Options.FastStringTables = FastStringTables;
 
   Options.MCOptions = InitMCTargetOptionsFromFlags();
   Options.JTType = JTableType;
@@ -0,0 +1,49 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace llvm {
+
+class Module;
+class TargetOptions;
+class raw_ostream;
+
+/// Split M into OSs.size() partitions, and generate code for each. Writes
+/// OSs.size() output files to the output streams in OSs. The resulting output
+/// files if linked together are intended to be equivalent to the single output
+/// file that would have been code generated from M.
+///
+/// If OSs.size() is 1, M is code generated as is, on the calling thread.
+/// Otherwise the local symbols of M are externalized (see SplitModule), each
+/// partition is round-tripped through bitcode into its own LLVMContext and
+/// code generation runs on one thread per partition.
+///
+/// \returns true on success, false if the target could not be found or does
+/// not support the requested file type; ErrMsg then describes the failure.
+bool splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs, StringRef CPU,
+                  StringRef Features, const TargetOptions &Options,
+                  std::string &ErrMsg, Reloc::Model RM = Reloc::Default,
+                  CodeModel::Model CM = CodeModel::Default,
+                  CodeGenOpt::Level OL = CodeGenOpt::Default,
+                  TargetMachine::CodeGenFileType FT =
+                      TargetMachine::CGFT_ObjectFile);
+
+} // namespace llvm
+
+#endif
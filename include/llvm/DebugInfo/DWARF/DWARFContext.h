@@ -10,7 +10,9 @@
 #ifndef LLVM_LIB_DEBUGINFO_DWARFCONTEXT_H
 #define LLVM_LIB_DEBUGINFO_DWARFCONTEXT_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/DebugInfo/DWARF/DIContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFCompileUnit.h"
@@ -21,10 +23,15 @@
 #include "llvm/DebugInfo/DWARF/DWARFDebugRangeList.h"
 #include "llvm/DebugInfo/DWARF/DWARFSection.h"
 #include "llvm/DebugInfo/DWARF/DWARFTypeUnit.h"
+#include <deque>
+#include <list>
+#include <mutex>
 #include <vector>
 
 namespace llvm {
 
+class ThreadPool;
+
 /// DWARFContext
 /// This data structure is the top level entity that deals with dwarf debug
 /// information parsing. The actual data is supplied through pure virtual
@@ -39,6 +46,20 @@ class DWARFContext : public DIContext {
   std::unique_ptr<DWARFDebugLine> Line;
   std::unique_ptr<DWARFDebugFrame> DebugFrame;
 
+  /// Guards Line, so line tables of different units can be parsed and cached
+  /// concurrently.
+  std::mutex LineTableMutex;
+
+  /// The maximum number of compile units that keep their DIEs and line table
+  /// after an address query, or 0 for no limit.
+  unsigned MaxResidentUnits;
+
+  /// Compile units touched by address queries, least recently used first.
+  std::list<DWARFCompileUnit *> ResidentUnits;
+  /// The entries of ResidentUnits, by compile unit.
+  DenseMap<DWARFCompileUnit *, std::list<DWARFCompileUnit *>::iterator>
+      ResidentUnitIndex;
+
   DWARFUnitSection<DWARFCompileUnit> DWOCUs;
   std::vector<DWARFUnitSection<DWARFTypeUnit>> DWOTUs;
   std::unique_ptr<DWARFDebugAbbrev> AbbrevDWO;
@@ -64,7 +85,7 @@ class DWARFContext : public DIContext {
   void parseDWOTypeUnits();
 
 public:
-  DWARFContext() : DIContext(CK_DWARF) {}
+  DWARFContext() : DIContext(CK_DWARF), MaxResidentUnits(0) {}
 
   static bool classof(const DIContext *DICtx) {
     return DICtx->getKind() == CK_DWARF;
@@ -155,8 +176,23 @@ public:
   const DWARFDebugFrame *getDebugFrame();
 
   /// Get a pointer to a parsed line table corresponding to a compile unit.
+  /// This may be called concurrently for different units.
   const DWARFDebugLine::LineTable *getLineTableForUnit(DWARFUnit *cu);
 
+  /// Extract the DIEs and line tables of all the compile units and build the
+  /// address ranges map up front, spreading the work across \p Pool. Later
+  /// queries then only need to look up the cached results. With a limit set by
+  /// setMaxResidentUnits, only that many units are preloaded. This returns
+  /// once all the work is done; it must not be called concurrently with other
+  /// queries on this context.
+  void preloadUnits(ThreadPool &Pool);
+
+  /// Limit the number of compile units whose DIEs and line table are kept in
+  /// memory by address queries. When a query touches a new unit, the least
+  /// recently used ones are released and parsed again if they are queried
+  /// later. A limit of 0, the default, keeps every unit that was touched.
+  void setMaxResidentUnits(unsigned N);
+
   DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
   DILineInfoTable getLineInfoForAddressRange(uint64_t Address, uint64_t Size,
@@ -207,11 +243,19 @@ private:
   /// Return the compile unit which contains instruction with provided
   /// address.
   DWARFCompileUnit *getCompileUnitForAddress(uint64_t Address);
+
+  /// Mark \p CU as the most recently queried unit and release the least
+  /// recently used ones beyond MaxResidentUnits.
+  void touchUnit(DWARFCompileUnit *CU);
+
+  /// Drop the DIEs and the cached line table of \p CU.
+  void releaseUnit(DWARFCompileUnit *CU);
 };
 
 /// DWARFContextInMemory is the simplest possible implementation of a
 /// DWARFContext. It assumes all content is available in memory and stores
-/// pointers to it.
+/// pointers to it. Compressed sections are decompressed when they are first
+/// used.
 class DWARFContextInMemory : public DWARFContext {
   virtual void anchor();
   bool IsLittleEndian;
@@ -245,45 +289,113 @@ class DWARFContextInMemory : public DWARFContext {
   DWARFSection AppleNamespacesSection;
   DWARFSection AppleObjCSection;
 
-  SmallVector<SmallString<32>, 4> UncompressedSections;
+  /// A compressed debug section. It is only decompressed when one of the
+  /// sections it provides the contents of is first used.
+  struct CompressedSection {
+    StringRef Data;
+    uint64_t OriginalSize;
+    /// The section contents that are set once this section is decompressed.
+    SmallVector<StringRef *, 1> Contents;
+    std::once_flag Decompressed;
+    SmallString<0> Uncompressed;
+  };
+  std::deque<CompressedSection> CompressedSections;
+  DenseMap<const StringRef *, CompressedSection *> CompressedSectionMap;
+
+  /// Return the section contents \p Data, decompressing them first if they
+  /// belong to a compressed section that hasn't been used yet. This is safe to
+  /// call from several threads.
+  StringRef getContents(StringRef &Data) {
+    if (!CompressedSectionMap.empty())
+      decompress(Data);
+    return Data;
+  }
+  const DWARFSection &getContents(DWARFSection &Section) {
+    getContents(Section.Data);
+    return Section;
+  }
+  const TypeSectionMap &getContents(TypeSectionMap &Sections) {
+    for (auto &I : Sections)
+      getContents(I.second.Data);
+    return Sections;
+  }
+  void decompress(StringRef &Data);
 
 public:
   DWARFContextInMemory(const object::ObjectFile &Obj);
   bool isLittleEndian() const override { return IsLittleEndian; }
   uint8_t getAddressSize() const override { return AddressSize; }
-  const DWARFSection &getInfoSection() override { return InfoSection; }
-  const TypeSectionMap &getTypesSections() override { return TypesSections; }
-  StringRef getAbbrevSection() override { return AbbrevSection; }
-  const DWARFSection &getLocSection() override { return LocSection; }
-  StringRef getARangeSection() override { return ARangeSection; }
-  StringRef getDebugFrameSection() override { return DebugFrameSection; }
-  const DWARFSection &getLineSection() override { return LineSection; }
-  StringRef getStringSection() override { return StringSection; }
-  StringRef getRangeSection() override { return RangeSection; }
-  StringRef getPubNamesSection() override { return PubNamesSection; }
-  StringRef getPubTypesSection() override { return PubTypesSection; }
-  StringRef getGnuPubNamesSection() override { return GnuPubNamesSection; }
-  StringRef getGnuPubTypesSection() override { return GnuPubTypesSection; }
-  const DWARFSection& getAppleNamesSection() override { return AppleNamesSection; }
-  const DWARFSection& getAppleTypesSection() override { return AppleTypesSection; }
-  const DWARFSection& getAppleNamespacesSection() override { return AppleNamespacesSection; }
-  const DWARFSection& getAppleObjCSection() override { return AppleObjCSection; }
+  const DWARFSection &getInfoSection() override {
+    return getContents(InfoSection);
+  }
+  const TypeSectionMap &getTypesSections() override {
+    return getContents(TypesSections);
+  }
+  StringRef getAbbrevSection() override { return getContents(AbbrevSection); }
+  const DWARFSection &getLocSection() override {
+    return getContents(LocSection);
+  }
+  StringRef getARangeSection() override { return getContents(ARangeSection); }
+  StringRef getDebugFrameSection() override {
+    return getContents(DebugFrameSection);
+  }
+  const DWARFSection &getLineSection() override {
+    return getContents(LineSection);
+  }
+  StringRef getStringSection() override { return getContents(StringSection); }
+  StringRef getRangeSection() override { return getContents(RangeSection); }
+  StringRef getPubNamesSection() override {
+    return getContents(PubNamesSection);
+  }
+  StringRef getPubTypesSection() override {
+    return getContents(PubTypesSection);
+  }
+  StringRef getGnuPubNamesSection() override {
+    return getContents(GnuPubNamesSection);
+  }
+  StringRef getGnuPubTypesSection() override {
+    return getContents(GnuPubTypesSection);
+  }
+  const DWARFSection& getAppleNamesSection() override {
+    return getContents(AppleNamesSection);
+  }
+  const DWARFSection& getAppleTypesSection() override {
+    return getContents(AppleTypesSection);
+  }
+  const DWARFSection& getAppleNamespacesSection() override {
+    return getContents(AppleNamespacesSection);
+  }
+  const DWARFSection& getAppleObjCSection() override {
+    return getContents(AppleObjCSection);
+  }
 
   // Sections for DWARF5 split dwarf proposal.
-  const DWARFSection &getInfoDWOSection() override { return InfoDWOSection; }
+  const DWARFSection &getInfoDWOSection() override {
+    return getContents(InfoDWOSection);
+  }
   const TypeSectionMap &getTypesDWOSections() override {
-    return TypesDWOSections;
+    return getContents(TypesDWOSections);
+  }
+  StringRef getAbbrevDWOSection() override {
+    return getContents(AbbrevDWOSection);
+  }
+  const DWARFSection &getLineDWOSection() override {
+    return getContents(LineDWOSection);
+  }
+  const DWARFSection &getLocDWOSection() override {
+    return getContents(LocDWOSection);
+  }
+  StringRef getStringDWOSection() override {
+    return getContents(StringDWOSection);
   }
-  StringRef getAbbrevDWOSection() override { return AbbrevDWOSection; }
-  const DWARFSection &getLineDWOSection() override { return LineDWOSection; }
-  const DWARFSection &getLocDWOSection() override { return LocDWOSection; }
-  StringRef getStringDWOSection() override { return StringDWOSection; }
   StringRef getStringOffsetDWOSection() override {
-    return StringOffsetDWOSection;
+    return getContents(StringOffsetDWOSection);
+  }
+  StringRef getRangeDWOSection() override {
+    return getContents(RangeDWOSection);
   }
-  StringRef getRangeDWOSection() override { return RangeDWOSection; }
   StringRef getAddrSection() override {
-    return AddrSection;
+    return getContents(AddrSection);
   }
 };
 
@@ -17,10 +17,14 @@
 namespace llvm {
 
 class DWARFContext;
+class ThreadPool;
 
 class DWARFDebugAranges {
 public:
-  void generate(DWARFContext *CTX);
+  /// Build the address map from .debug_aranges and, for the compile units it
+  /// doesn't describe, from the DIEs. If \p Pool is given, the ranges of the
+  /// compile units are collected concurrently on it.
+  void generate(DWARFContext *CTX, ThreadPool *Pool = nullptr);
   uint32_t findAddress(uint64_t Address) const;
 
 private:
@@ -208,6 +208,11 @@ public:
   const LineTable *getLineTable(uint32_t offset) const;
   const LineTable *getOrParseLineTable(DataExtractor debug_line_data,
                                        uint32_t offset);
+  /// Cache a line table parsed by the caller for the given offset. If a table
+  /// is already cached there, \p LT is dropped. Returns the cached table.
+  const LineTable *insertLineTable(uint32_t offset, LineTable &&LT);
+  /// Drop the cached line table at the given offset, if any.
+  void eraseLineTable(uint32_t offset) { LineTableMap.erase(offset); }
 
 private:
   struct ParsingState {
@@ -123,6 +123,26 @@ class DWARFUnit {
   // The compile unit debug information entry items.
   std::vector<DWARFDebugInfoEntryMinimal> DieArray;
 
+  /// A subprogram or inlined subroutine DIE that has address ranges, and the
+  /// closest such DIE enclosing it.
+  struct AddressIndexEntry {
+    uint32_t DIEIndex;
+    uint32_t Parent; // Index of the enclosing entry, or -1U.
+  };
+  /// A piece of the address space of the unit, from Address up to the start
+  /// of the next segment, and the innermost entry of the inlined chain
+  /// covering it (or -1U).
+  struct AddressIndexSegment {
+    uint64_t Address;
+    uint32_t Entry;
+  };
+  /// Maps addresses to subroutine DIEs. Entries are in DIE order and
+  /// segments are sorted by address. The index only refers to DIEs by
+  /// position, so it survives releaseDIEs().
+  std::vector<AddressIndexEntry> AddressIndexEntries;
+  std::vector<AddressIndexSegment> AddressIndexSegments;
+  bool AddressIndexBuilt;
+
   class DWOHolder {
     object::OwningBinary<object::ObjectFile> DWOFile;
     std::unique_ptr<DWARFContext> DWOContext;
@@ -220,6 +240,20 @@ public:
     return DieArray.size();
   }
 
+  /// \brief Returns true if the DIEs beyond the compile unit DIE are
+  /// currently extracted.
+  bool hasExtractedDIEs() const { return DieArray.size() > 1; }
+
+  /// \brief Drop all the DIEs but the compile unit DIE, as well as the .dwo
+  /// file of the unit if it was loaded. They are extracted again when needed.
+  /// Pointers to the dropped DIEs are invalidated.
+  void releaseDIEs();
+
+  /// \brief Build the index mapping addresses to subprogram and inlined
+  /// subroutine DIEs, if it isn't built yet. Address queries build it on
+  /// demand, calling this ahead of time just moves the work.
+  void buildAddressIndex();
+
   /// \brief Return the index of a DIE inside the unit's DIE vector.
   ///
   /// It is illegal to call this method with a DIE that hasn't be
@@ -274,10 +308,9 @@ private:
   /// it was actually constructed.
   bool parseDWO();
 
-  /// getSubprogramForAddress - Returns subprogram DIE with address range
-  /// encompassing the provided address. The pointer is alive as long as parsed
-  /// compile unit DIEs are not cleared.
-  const DWARFDebugInfoEntryMinimal *getSubprogramForAddress(uint64_t Address);
+  /// lookupAddressIndex - Returns the address index entry of the innermost
+  /// subroutine DIE whose address ranges contain the given address, or -1U.
+  uint32_t lookupAddressIndex(uint64_t Address);
 };
 
 }
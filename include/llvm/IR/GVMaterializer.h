@@ -53,6 +53,11 @@ public:
   ///
   virtual std::error_code MaterializeModule(Module *M) = 0;
 
+  /// Make sure the module-level metadata has been read, for materializers that
+  /// defer it.
+  ///
+  virtual std::error_code materializeMetadata() = 0;
+
   virtual std::vector<StructType *> getIdentifiedStructTypes() const = 0;
 };
 
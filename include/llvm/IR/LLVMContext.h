@@ -158,6 +158,26 @@ public:
   /// any global mutex or cannot block the execution in another LLVM context.
   void yield();
 
+  /// \brief Make the uniquing of constants, types, attributes and metadata in
+  /// this context safe to use from several threads at once.
+  ///
+  /// Each family of uniquing tables is then guarded by a lock of its own, and
+  /// so are the use lists of values, the value handle lists, the intrinsic ID
+  /// cache, and the symbol tables of modules as new functions and global
+  /// variables are added to them or looked up by name. This lets functions of
+  /// a module be transformed on separate threads, as long as no thread walks
+  /// the use list of a value shared between functions or otherwise changes IR
+  /// outside of the function it works on. It must be called before the
+  /// context is shared between threads.
+  void enableConcurrentUniquing();
+
+  /// \brief Go back to unlocked uniquing, once no other thread uses this
+  /// context any more.
+  void disableConcurrentUniquing();
+
+  /// \brief Whether concurrent uniquing is enabled on this context.
+  bool hasConcurrentUniquing() const { return ConcurrentUniquing; }
+
   /// emitError - Emit an error message to the currently installed error handler
   /// with optional location information.  This function returns, so code should
   /// be prepared to drop the erroneous construct on the floor and "not crash".
@@ -188,6 +208,11 @@ private:
 
   // Module needs access to the add/removeModule methods.
   friend class Module;
+
+  /// Whether concurrent uniquing is enabled. It is kept here rather than in
+  /// pImpl because use list updates check it; LLVMContextImpl refers to it.
+  bool ConcurrentUniquing;
+  friend class LLVMContextImpl;
 };
 
 /// getGlobalContext - Returns a global context.  This is for LLVM clients that
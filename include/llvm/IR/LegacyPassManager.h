@@ -58,6 +58,12 @@ public:
   /// whether any of the passes modifies the module, and if so, return true.
   bool run(Module &M);
 
+  /// setNumThreads - Run function passes over the functions of a module on N
+  /// threads.  This only happens for runs of function passes that all
+  /// provide Pass::createReplica(); others still visit one function at a
+  /// time.  Doing so makes the module's context use concurrent uniquing.
+  void setNumThreads(unsigned N);
+
 private:
   /// PassManagerImpl_New is the actual class. PassManager is just the
   /// wraper to publish simple pass manager interface
@@ -20,6 +20,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Pass.h"
 #include <map>
+#include <memory>
 #include <vector>
 
 //===----------------------------------------------------------------------===//
@@ -95,6 +96,7 @@ namespace llvm {
   class Module;
   class Pass;
   class StringRef;
+  class ThreadPool;
   class Value;
   class Timer;
   class PMDataManager;
@@ -227,6 +229,15 @@ public:
   void dumpPasses() const;
   void dumpArguments() const;
 
+  /// Set the number of threads a function pass manager may use to run its
+  /// passes over the functions of a module.
+  void setNumThreads(unsigned N);
+  unsigned getNumThreads() const { return NumThreads; }
+
+  /// The threads that function pass managers run their passes on, created on
+  /// first use and shared by every run of this manager.
+  ThreadPool &getThreadPool();
+
   // Active Pass Managers
   PMStack activeStack;
 
@@ -260,6 +271,9 @@ private:
   /// FIXME: This is an egregious hack because querying the pass registry is
   /// either slow or racy.
   mutable DenseMap<AnalysisID, const PassInfo *> AnalysisPassInfos;
+
+  unsigned NumThreads;
+  std::unique_ptr<ThreadPool> Pool;
 };
 
 
@@ -470,6 +484,12 @@ public:
   PassManagerType getPassManagerType() const override {
     return PMT_FunctionPassManager;
   }
+
+private:
+  /// Run the passes over the definitions in M on several threads, each of
+  /// which drives its own replica of this manager. Return false without
+  /// running anything if a pass can't be replicated.
+  bool runOnModuleInParallel(Module &M, bool &Changed);
 };
 
 Timer *getPassTimer(Pass *);
@@ -506,6 +506,10 @@ public:
   /// Materializer.
   std::error_code materializeAllPermanently();
 
+  /// Make sure the module-level metadata (named metadata and the metadata
+  /// referenced from globals) is fully read, if the Materializer defers it.
+  std::error_code materializeMetadata();
+
 /// @}
 /// @name Direct access to the globals list, functions list, and symbol table
 /// @{
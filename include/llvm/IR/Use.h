@@ -29,6 +29,7 @@
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/Support/CBindingWrapping.h"
 #include "llvm/Support/Compiler.h"
+#include <atomic>
 #include <cstddef>
 #include <iterator>
 
@@ -76,13 +77,20 @@ public:
   // a pointer back to their User with the bottom bit set.
   typedef PointerIntPair<User *, 1, unsigned> UserRef;
 
+  /// \brief The number of contexts with concurrent uniquing enabled.
+  ///
+  /// Only while this is non-zero can a use list be updated from several
+  /// threads at once, so only then does updating a use look at the context of
+  /// the used value to see whether it has to take a lock.
+  static std::atomic<unsigned> NumConcurrentContexts;
+
 private:
   Use(const Use &U) = delete;
 
   /// Destructor - Only for zap()
   ~Use() {
     if (Val)
-      removeFromList();
+      set(nullptr);
   }
 
   enum PrevPtrTag { zeroDigitTag, oneDigitTag, stopTag, fullStopTag };
@@ -137,6 +145,8 @@ private:
   PointerIntPair<Use **, 2, PrevPtrTag> Prev;
 
   void setPrev(Use **NewPrev) { Prev.setPointer(NewPrev); }
+  void setMaybeConcurrently(Value *V);
+  void setConcurrently(Value *V);
   void addToList(Use **List) {
     Next = *List;
     if (Next)
@@ -524,6 +524,8 @@ inline raw_ostream &operator<<(raw_ostream &OS, const Value &V) {
 }
 
 void Use::set(Value *V) {
+  if (LLVM_UNLIKELY(NumConcurrentContexts.load(std::memory_order_relaxed)))
+    return setMaybeConcurrently(V);
   if (Val) removeFromList();
   Val = V;
   if (V) V->addUse(*this);
@@ -14,6 +14,7 @@
 #ifndef LLVM_IR_VALUESYMBOLTABLE_H
 #define LLVM_IR_VALUESYMBOLTABLE_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Value.h"
 #include "llvm/Support/DataTypes.h"
@@ -56,7 +57,7 @@ public:
 /// @{
 public:
 
-  ValueSymbolTable() : vmap(0), LastUnique(0) {}
+  ValueSymbolTable() : vmap(0), LastUnique(0), UniquedNames(nullptr) {}
   ~ValueSymbolTable();
 
 /// @}
@@ -82,6 +83,14 @@ public:
   /// @brief Print out symbol table on stderr
   void dump() const;
 
+  /// While \p Log is set, the values whose names conflict and are made unique
+  /// are recorded in it, with the length of the name they asked for. Values
+  /// that are inserted under the name they asked for are removed from it.
+  /// @brief Record which names get a suffix to make them unique
+  void setUniquedNameLog(DenseMap<const Value *, unsigned> *Log) {
+    UniquedNames = Log;
+  }
+
 /// @}
 /// @name Iteration
 /// @{
@@ -124,6 +133,8 @@ private:
 private:
   ValueMap vmap;                    ///< The map that holds the symbol table.
   mutable uint32_t LastUnique; ///< Counter for tracking unique names
+  /// Where to record the names that were made unique, if anywhere.
+  DenseMap<const Value *, unsigned> *UniquedNames;
 
 /// @}
 };
@@ -27,10 +27,12 @@ class LLVMContext;
 /// If the given file holds a bitcode image, return a Module
 /// for it which does lazy deserialization of function bodies.  Otherwise,
 /// attempt to parse it as LLVM Assembly and return a fully populated
-/// Module.
+/// Module. If ShouldLazyLoadMetadata is true, the module-level metadata of a
+/// bitcode file is also only read on demand.
 std::unique_ptr<Module> getLazyIRFileModule(StringRef Filename,
                                             SMDiagnostic &Err,
-                                            LLVMContext &Context);
+                                            LLVMContext &Context,
+                                            bool ShouldLazyLoadMetadata = false);
 
 /// If the given MemoryBuffer holds a bitcode image, return a Module
 /// for it.  Otherwise, attempt to parse it as LLVM Assembly and return
@@ -132,6 +132,12 @@ struct LTOCodeGenerator {
   // if the compilation was not successful.
   const void *compileOptimized(size_t *length, std::string &errMsg);
 
+  // Compiles the merged optimized module into out.size() object files, each
+  // representing a linkable partition of the module. If out contains more than
+  // one element, the module is split and code generation is done in parallel
+  // with out.size() threads. Returns true on success.
+  bool compileOptimized(ArrayRef<raw_ostream *> out, std::string &errMsg);
+
   void setDiagnosticHandler(lto_diagnostic_handler_t, void *);
 
   LLVMContext &getContext() { return Context; }
@@ -13,6 +13,7 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/IR/DiagnosticInfo.h"
 
 namespace llvm {
@@ -26,6 +27,14 @@ class Type;
 /// something with it after the linking.
 class Linker {
 public:
+  enum Flags {
+    None = 0,
+    /// Only link in the definitions that the composite needs: those that it
+    /// already declares and those referenced from what gets linked. The
+    /// bodies of all the other source functions are never materialized.
+    LinkOnlyNeeded = 1 << 0
+  };
+
   struct StructTypeKeyInfo {
     struct KeyTy {
       ArrayRef<Type *> ETypes;
@@ -53,9 +62,18 @@ public:
     // The set of identified but non opaque structures in the composite module.
     NonOpaqueStructTypeSet NonOpaqueStructTypes;
 
+    // The named ones of those, by a hash of their name without the numeric
+    // suffix LLVMContext adds, and of their shape. Isomorphic types hash the
+    // same, so this finds the candidates for a type without comparing it
+    // against every type in the composite.
+    DenseMap<size_t, TinyPtrVector<StructType *>> NonOpaqueStructTypesByShape;
+
     void addNonOpaque(StructType *Ty);
     void addOpaque(StructType *Ty);
     StructType *findNonOpaque(ArrayRef<Type *> ETypes, bool IsPacked);
+    /// Return the types in the composite that may be isomorphic to \p Ty
+    /// and had the same name in their own module.
+    ArrayRef<StructType *> findNonOpaqueByShape(StructType *Ty);
     bool hasType(StructType *Ty);
   };
 
@@ -67,16 +85,19 @@ public:
   void deleteModule();
 
   /// \brief Link \p Src into the composite. The source is destroyed.
+  /// \p Flags is a combination of Linker::Flags.
   /// Returns true on error.
-  bool linkInModule(Module *Src);
+  bool linkInModule(Module *Src, unsigned Flags = Flags::None);
 
   /// \brief Set the composite to the passed-in module.
   void setModule(Module *Dst);
 
   static bool LinkModules(Module *Dest, Module *Src,
-                          DiagnosticHandlerFunction DiagnosticHandler);
+                          DiagnosticHandlerFunction DiagnosticHandler,
+                          unsigned Flags = Flags::None);
 
-  static bool LinkModules(Module *Dest, Module *Src);
+  static bool LinkModules(Module *Dest, Module *Src,
+                          unsigned Flags = Flags::None);
 
 private:
   void init(Module *M, DiagnosticHandlerFunction DiagnosticHandler);
@@ -18,6 +18,7 @@
 
 #include "llvm/MC/MCDirectives.h"
 #include "llvm/MC/MCDwarf.h"
+#include "llvm/MC/MCTargetOptions.h"
 #include "llvm/MC/MachineLocation.h"
 #include <cassert>
 #include <vector>
@@ -341,8 +342,20 @@ protected:
   /// construction (see LLVMTargetMachine::initAsmInfo()).
   bool UseIntegratedAssembler;
 
-  /// Compress DWARF debug sections. Defaults to false.
-  bool CompressDebugSections;
+  /// How to compress DWARF debug sections. Defaults to DebugCompression::None.
+  DebugCompression::Type CompressDebugSections;
+
+  /// Write the sections of object files on several threads, where the object
+  /// writer supports it. The ELF writer then holds the contents of all the
+  /// sections in memory before writing them out, as well as a copy of each
+  /// section being written, so this takes about as much memory again as the
+  /// object file. Defaults to false.
+  bool ParallelObjectWriting;
+
+  /// Lay out the string tables of object files in the order the strings were
+  /// added, without sharing the tails of strings that are suffixes of others.
+  /// The tables are cheaper to build but larger. Defaults to false.
+  bool FastStringTables;
 
 public:
   explicit MCAsmInfo();
@@ -524,11 +537,25 @@ public:
     UseIntegratedAssembler = Value;
   }
 
-  bool compressDebugSections() const { return CompressDebugSections; }
+  DebugCompression::Type compressDebugSections() const {
+    return CompressDebugSections;
+  }
 
-  void setCompressDebugSections(bool CompressDebugSections) {
+  void setCompressDebugSections(DebugCompression::Type CompressDebugSections) {
     this->CompressDebugSections = CompressDebugSections;
   }
+
+  bool parallelObjectWriting() const { return ParallelObjectWriting; }
+
+  void setParallelObjectWriting(bool ParallelObjectWriting) {
+    this->ParallelObjectWriting = ParallelObjectWriting;
+  }
+
+  bool fastStringTables() const { return FastStringTables; }
+
+  void setFastStringTables(bool FastStringTables) {
+    this->FastStringTables = FastStringTables;
+  }
 };
 }
 
@@ -43,10 +43,19 @@ private:
   /// lower ordinal will be valid.
   mutable DenseMap<const MCSectionData*, MCFragment*> LastValidFragment;
 
+  /// The first fragment whose offset is out of date because a fragment before
+  /// it changed size, if any. It and the valid fragments after it are still
+  /// laid out consistently with each other, just not with the ones before.
+  mutable DenseMap<const MCSectionData*, MCFragment*> FirstMovedFragment;
+
   /// \brief Make sure that the layout for the given fragment is valid, lazily
   /// computing it if necessary.
   void ensureValid(const MCFragment *F) const;
 
+  /// \brief Bring the offsets of the moved fragments up to date, up to and
+  /// including \p F.
+  void updateMovedFragments(const MCFragment *F) const;
+
   /// \brief Is the layout for this fragment valid?
   bool isFragmentValid(const MCFragment *F) const;
 
@@ -66,6 +75,11 @@ public:
   /// its bundle padding will be recomputed.
   void invalidateFragmentsFrom(MCFragment *F);
 
+  /// \brief Note that \p F changed size. Rather than being laid out again,
+  /// the fragments after it are moved when their layout is next needed, and
+  /// only until one of them ends up where it was before.
+  void moveFragmentsAfter(MCFragment *F);
+
   /// \brief Perform layout for a single fragment, assuming that the previous
   /// fragment has already been laid out correctly, and the parent section has
   /// been initialized.
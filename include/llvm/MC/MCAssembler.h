@@ -960,13 +960,29 @@ private:
   bool fragmentNeedsRelaxation(const MCRelaxableFragment *IF,
                                const MCAsmLayout &Layout) const;
 
+  /// \brief The fragments of a section that may still change size during
+  /// relaxation, in layout order.
+  struct RelaxationWorklist {
+    std::vector<MCFragment *> Fragments;
+
+    /// Whether the fragments after one that changed size can simply be moved,
+    /// rather than laid out again. This is not the case when the size of a
+    /// fragment can depend on more than its own offset.
+    bool CanMoveFragments;
+
+    RelaxationWorklist() : CanMoveFragments(true) {}
+  };
+
   /// \brief Perform one layout iteration and return true if any offsets
-  /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  /// were adjusted. \p Worklists is indexed by section ordinal.
+  bool layoutOnce(MCAsmLayout &Layout,
+                  std::vector<RelaxationWorklist> &Worklists);
 
   /// \brief Perform one layout iteration of the given section and return true
-  /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
+  /// if any offsets were adjusted. Only the fragments in \p Worklist are
+  /// relaxed; the ones that can't change any more are removed from it.
+  bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD,
+                         RelaxationWorklist &Worklist);
 
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
@@ -1001,10 +1017,15 @@ public:
   /// defining a separate atom.
   bool isSymbolLinkerVisible(const MCSymbol &SD) const;
 
-  /// Emit the section contents using the given object writer.
+  /// Emit the section contents using the assembler's object writer.
   void writeSectionData(const MCSectionData *Section,
                         const MCAsmLayout &Layout) const;
 
+  /// Emit the section contents using the given object writer. This only reads
+  /// the final layout, so different sections can be written concurrently.
+  void writeSectionData(const MCSectionData *Section, const MCAsmLayout &Layout,
+                        MCObjectWriter &OW) const;
+
   /// Check whether a given symbol has been flagged with .thumb_func.
   bool isThumbFunc(const MCSymbol *Func) const;
 
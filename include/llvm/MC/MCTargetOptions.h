@@ -16,6 +16,14 @@ namespace llvm {
 
 class StringRef;
 
+namespace DebugCompression {
+  enum Type {
+    None,   // Leave the debug sections uncompressed.
+    Zlib,   // Compress them into SHF_COMPRESSED sections (ELF gABI).
+    ZlibGnu // Compress them into .zdebug_* sections (GNU).
+  };
+}
+
 class MCTargetOptions {
 public:
   enum AsmInstrumentation {
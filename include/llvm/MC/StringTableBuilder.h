@@ -19,6 +19,8 @@ namespace llvm {
 /// \brief Utility for building string tables with deduplicated suffixes.
 class StringTableBuilder {
   SmallString<256> StringTable;
+  /// Maps each string to the order it was added in until the table is
+  /// finalized, and to its offset in the table after that.
   StringMap<size_t> StringIndexMap;
 
 public:
@@ -26,7 +28,8 @@ public:
   /// copy of s. Can only be used before the table is finalized.
   StringRef add(StringRef s) {
     assert(!isFinalized());
-    return StringIndexMap.insert(std::make_pair(s, 0)).first->first();
+    return StringIndexMap.insert(std::make_pair(s, StringIndexMap.size()))
+        .first->first();
   }
 
   enum Kind {
@@ -39,6 +42,11 @@ public:
   /// be added after this point.
   void finalize(Kind kind);
 
+  /// \brief Build the final table without merging suffixes, with the strings
+  /// in the order they were first added. This is cheaper than finalize but
+  /// produces a bigger table.
+  void finalizeInOrder(Kind kind);
+
   /// \brief Retrieve the string table data. Can only be used after the table
   /// is finalized.
   StringRef data() {
@@ -60,6 +68,8 @@ private:
   bool isFinalized() {
     return !StringTable.empty();
   }
+
+  void finalizeStringTable(Kind kind, bool Optimize);
 };
 
 } // end llvm namespace
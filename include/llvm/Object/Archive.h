@@ -14,6 +14,8 @@
 #ifndef LLVM_OBJECT_ARCHIVE_H
 #define LLVM_OBJECT_ARCHIVE_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Object/Binary.h"
@@ -21,6 +23,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <mutex>
 
 namespace llvm {
 namespace object {
@@ -75,6 +78,11 @@ public:
     }
 
     Child getNext() const;
+    const Archive *getParent() const { return Parent; }
+
+    /// \return true if the contents of this member are kept in a separate
+    /// file next to a thin archive rather than in the archive itself.
+    bool isThinMember() const;
 
     ErrorOr<StringRef> getName() const;
     StringRef getRawName() const { return getHeader()->getName(); }
@@ -94,7 +102,10 @@ public:
     /// \return the size in the archive header for this member.
     uint64_t getRawSize() const;
 
+    /// \return the contents stored in the archive. Thin members have none;
+    /// use getMemoryBufferRef to read them.
     StringRef getBuffer() const {
+      assert(!isThinMember() && "Thin member contents are not in the archive");
       return StringRef(Data.data() + StartOfFile, getSize());
     }
     uint64_t getChildOffset() const;
@@ -136,6 +147,7 @@ public:
     const Archive *Parent;
     uint32_t SymbolIndex;
     uint32_t StringIndex; // Extra index to the string.
+    friend class Archive;
 
   public:
     bool operator ==(const Symbol &other) const {
@@ -184,6 +196,7 @@ public:
   };
 
   Kind kind() const { return (Kind)Format; }
+  bool isThin() const { return IsThin; }
 
   child_iterator child_begin(bool SkipInternal = true) const;
   child_iterator child_end() const;
@@ -201,6 +214,10 @@ public:
   }
 
   // check if a symbol is in the archive
+  //
+  // The first call builds a hash table over the symbol table, so that looking
+  // up many names costs one pass over the symbol table rather than one pass
+  // per name.
   child_iterator findSym(StringRef name) const;
 
   bool hasSymbolTable() const;
@@ -212,6 +229,39 @@ private:
   child_iterator FirstRegular;
   unsigned Format : 2;
   unsigned IsThin : 1;
+
+  /// Hashes symbol names without copying them out of the archive buffer.
+  struct SymbolNameInfo {
+    static StringRef getEmptyKey() {
+      return StringRef(reinterpret_cast<const char *>(~uintptr_t(0)), 0);
+    }
+    static StringRef getTombstoneKey() {
+      return StringRef(reinterpret_cast<const char *>(~uintptr_t(1)), 0);
+    }
+    static unsigned getHashValue(StringRef Name) { return hash_value(Name); }
+    static bool isSpecialKey(StringRef Name) {
+      return Name.data() == getEmptyKey().data() ||
+             Name.data() == getTombstoneKey().data();
+    }
+    static bool isEqual(StringRef LHS, StringRef RHS) {
+      if (isSpecialKey(LHS) || isSpecialKey(RHS))
+        return LHS.data() == RHS.data();
+      return LHS == RHS;
+    }
+  };
+
+  /// Maps the names in the symbol table to the first symbol with that name,
+  /// as its (SymbolIndex, StringIndex) pair. Built lazily by findSym.
+  mutable DenseMap<StringRef, std::pair<uint32_t, uint32_t>, SymbolNameInfo>
+      SymbolIndex;
+  mutable std::once_flag SymbolIndexFlag;
+  void buildSymbolIndex() const;
+
+  /// The files backing the members of a thin archive that have been read so
+  /// far, keyed by member offset.
+  mutable DenseMap<uint64_t, std::unique_ptr<MemoryBuffer>> ThinBuffers;
+  mutable std::mutex ThinBuffersMutex;
+  ErrorOr<StringRef> getThinMemberBuffer(const Child &C) const;
 };
 
 }
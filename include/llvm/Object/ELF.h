@@ -244,7 +244,6 @@ private:
   const Elf_Shdr *dot_symtab_sec;   // Symbol table section.
 
   const Elf_Shdr *SymbolTableSectionHeaderIndex;
-  DenseMap<const Elf_Sym *, ELF::Elf64_Word> ExtendedSymbolTable;
 
   const Elf_Shdr *dot_gnu_version_sec;   // .gnu.version
   const Elf_Shdr *dot_gnu_version_r_sec; // .gnu.version_r
@@ -296,6 +295,10 @@ private:
   void LoadVersionNeeds(const Elf_Shdr *ec) const;
   void LoadVersionMap() const;
 
+  /// Return the section index of \p symb, whose st_shndx is SHN_XINDEX, from
+  /// the SHT_SYMTAB_SHNDX section.
+  ELF::Elf64_Word getExtendedSymbolTableIndex(const Elf_Sym *symb) const;
+
 public:
   template<typename T>
   const T        *getEntry(uint32_t Section, uint32_t Entry) const;
@@ -511,10 +514,31 @@ void ELFFile<ELFT>::LoadVersionMap() const {
     LoadVersionNeeds(dot_gnu_version_r_sec);
 }
 
+template <class ELFT>
+ELF::Elf64_Word
+ELFFile<ELFT>::getExtendedSymbolTableIndex(const Elf_Sym *symb) const {
+  // The SHT_SYMTAB_SHNDX section has an entry for every symbol in .symtab.
+  // Read it in place rather than indexing it up front, which would touch the
+  // whole symbol table of objects with many sections.
+  if (!SymbolTableSectionHeaderIndex || !dot_symtab_sec ||
+      !dot_symtab_sec->sh_entsize)
+    return 0;
+  const uint8_t *SymTab = base() + dot_symtab_sec->sh_offset;
+  const uint8_t *Sym = reinterpret_cast<const uint8_t *>(symb);
+  if (Sym < SymTab || Sym >= SymTab + dot_symtab_sec->sh_size)
+    return 0;
+  uint64_t Index = (Sym - SymTab) / dot_symtab_sec->sh_entsize;
+  if ((Index + 1) * sizeof(Elf_Word) > SymbolTableSectionHeaderIndex->sh_size)
+    return 0;
+  const Elf_Word *ShndxTable = reinterpret_cast<const Elf_Word *>(
+      base() + SymbolTableSectionHeaderIndex->sh_offset);
+  return ShndxTable[Index];
+}
+
 template <class ELFT>
 ELF::Elf64_Word ELFFile<ELFT>::getSymbolTableIndex(const Elf_Sym *symb) const {
   if (symb->st_shndx == ELF::SHN_XINDEX)
-    return ExtendedSymbolTable.lookup(symb);
+    return getExtendedSymbolTableIndex(symb);
   return symb->st_shndx;
 }
 
@@ -522,7 +546,7 @@ template <class ELFT>
 const typename ELFFile<ELFT>::Elf_Shdr *
 ELFFile<ELFT>::getSection(const Elf_Sym *symb) const {
   if (symb->st_shndx == ELF::SHN_XINDEX)
-    return getSection(ExtendedSymbolTable.lookup(symb));
+    return getSection(getExtendedSymbolTableIndex(symb));
   if (symb->st_shndx >= ELF::SHN_LORESERVE)
     return nullptr;
   return getSection(symb->st_shndx);
@@ -720,18 +744,6 @@ ELFFile<ELFT>::ELFFile(StringRef Object, std::error_code &ec)
     VerifyStrTab(dot_shstrtab_sec);
   }
 
-  // Build symbol name side-mapping if there is one.
-  if (SymbolTableSectionHeaderIndex) {
-    const Elf_Word *ShndxTable = reinterpret_cast<const Elf_Word*>(base() +
-                                      SymbolTableSectionHeaderIndex->sh_offset);
-    for (Elf_Sym_Iter SI = begin_symbols(), SE = end_symbols(); SI != SE;
-         ++SI) {
-      if (*ShndxTable != ELF::SHN_UNDEF)
-        ExtendedSymbolTable[&*SI] = *ShndxTable;
-      ++ShndxTable;
-    }
-  }
-
   // Scan program headers.
   for (Elf_Phdr_Iter PhdrI = begin_program_headers(),
                      PhdrE = end_program_headers();
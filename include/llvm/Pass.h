@@ -164,6 +164,17 @@ public:
   ///
   virtual void releaseMemory();
 
+  /// createReplica - Return a new pass configured like this one, to be run on
+  /// other functions of the module at the same time as this pass.  Passes
+  /// that only look at and change the function they are run on may implement
+  /// this.  That rules out reading the users of constants and globals, such
+  /// as with hasOneUse(), since other threads may be changing them.  The
+  /// default of null keeps a pipeline containing the pass sequential.
+  /// Replicas are initialized but not finalized; doFinalization only runs on
+  /// the original pass.
+  ///
+  virtual Pass *createReplica() const { return nullptr; }
+
   /// getAdjustedAnalysisPointer - This method is used when a pass implements
   /// an analysis interface through multiple inheritance.  If needed, it should
   /// override this to adjust the this pointer as needed for the specified pass
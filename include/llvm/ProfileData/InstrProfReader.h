@@ -17,6 +17,7 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorOr.h"
@@ -24,6 +25,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include <iterator>
+#include <list>
 
 namespace llvm {
 
@@ -239,21 +241,11 @@ public:
     return StringRef((const char *)D, N);
   }
 
-  data_type ReadData(StringRef K, const unsigned char *D, offset_type N) {
-    DataBuffer.clear();
-    if (N % sizeof(uint64_t))
-      // The data is corrupt, don't try to read it.
-      return data_type("", DataBuffer);
-
-    using namespace support;
-    // We just treat the data as opaque here. It's simpler to handle in
-    // IndexedInstrProfReader.
-    unsigned NumEntries = N / sizeof(uint64_t);
-    DataBuffer.reserve(NumEntries);
-    for (unsigned I = 0; I < NumEntries; ++I)
-      DataBuffer.push_back(endian::readNext<uint64_t, little, unaligned>(D));
-    return data_type(K, DataBuffer);
-  }
+  /// Read the data of a record. The records aren't padded, so the data is
+  /// only aligned for some of them. When it is and the host is little endian
+  /// the returned data points straight into the profile, otherwise into a
+  /// buffer that the next call overwrites.
+  data_type ReadData(StringRef K, const unsigned char *D, offset_type N);
 };
 typedef OnDiskIterableChainedHashTable<InstrProfLookupTrait>
     InstrProfReaderIndex;
@@ -261,6 +253,15 @@ typedef OnDiskIterableChainedHashTable<InstrProfLookupTrait>
 /// Reader for the indexed binary instrprof format.
 class IndexedInstrProfReader : public InstrProfReader {
 private:
+  /// A recently looked up function, with its data split per function hash.
+  struct CachedRecord {
+    StringRef Name;
+    /// Decoded data, if the profile's data can't be used in place.
+    std::vector<uint64_t> Storage;
+    /// The counts for each function hash.
+    std::vector<std::pair<uint64_t, ArrayRef<uint64_t>>> Counts;
+  };
+
   /// The profile data file contents.
   std::unique_ptr<MemoryBuffer> DataBuffer;
   /// The index into the profile data.
@@ -273,12 +274,22 @@ private:
   uint64_t FormatVersion;
   /// The maximal execution count among all functions.
   uint64_t MaxFunctionCount;
+  /// The most recently looked up functions, most recent first.
+  std::list<CachedRecord> RecordCache;
+  /// The fully decoded entries of RecordCache, by function name.
+  StringMap<std::list<CachedRecord>::iterator> RecordCacheIndex;
+  /// The maximum number of entries in RecordCache.
+  unsigned RecordCacheSize;
 
   IndexedInstrProfReader(const IndexedInstrProfReader &) = delete;
   IndexedInstrProfReader &operator=(const IndexedInstrProfReader &) = delete;
+
+  std::error_code lookupRecord(StringRef FuncName,
+                               const CachedRecord *&Record);
 public:
   IndexedInstrProfReader(std::unique_ptr<MemoryBuffer> DataBuffer)
-      : DataBuffer(std::move(DataBuffer)), Index(nullptr), CurrentOffset(0) {}
+      : DataBuffer(std::move(DataBuffer)), Index(nullptr), CurrentOffset(0),
+        RecordCacheSize(16) {}
 
   /// Return true if the given buffer is in an indexed instrprof format.
   static bool hasFormat(const MemoryBuffer &DataBuffer);
@@ -291,6 +302,13 @@ public:
   /// Fill Counts with the profile data for the given function name.
   std::error_code getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                                     std::vector<uint64_t> &Counts);
+  /// Point Counts at the profile data for the given function name, without
+  /// copying it. The data stays valid until the next lookup on this reader.
+  std::error_code getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
+                                    ArrayRef<uint64_t> &Counts);
+  /// Set how many recently looked up functions are kept decoded, so that
+  /// looking them up again skips the hash table. At least one is kept.
+  void setRecordCacheSize(unsigned Size);
   /// Return the maximum of all known function counts.
   uint64_t getMaximumFunctionCount() { return MaxFunctionCount; }
 
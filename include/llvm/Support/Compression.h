@@ -14,6 +14,7 @@
 #ifndef LLVM_SUPPORT_COMPRESSION_H
 #define LLVM_SUPPORT_COMPRESSION_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/DataTypes.h"
 #include <memory>
@@ -45,6 +46,13 @@ bool isAvailable();
 Status compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
                 CompressionLevel Level = DefaultCompression);
 
+/// Compress the concatenation of \p InputBuffers into a single zlib stream,
+/// appending it to \p CompressedBuffer. The input is streamed through the
+/// compressor piece by piece, so it never has to be copied into one buffer.
+Status compress(ArrayRef<StringRef> InputBuffers,
+                SmallVectorImpl<char> &CompressedBuffer,
+                CompressionLevel Level = DefaultCompression);
+
 Status uncompress(StringRef InputBuffer,
                   SmallVectorImpl<char> &UncompressedBuffer,
                   size_t UncompressedSize);
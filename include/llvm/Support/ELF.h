@@ -665,6 +665,10 @@ enum : unsigned {
   // This section holds Thread-Local Storage.
   SHF_TLS = 0x400U,
 
+  // This section holds compressed data, which starts with a compression
+  // header (Elf32_Chdr or Elf64_Chdr).
+  SHF_COMPRESSED = 0x800U,
+
   // This section is excluded from the final executable or shared library.
   SHF_EXCLUDE = 0x80000000U,
 
@@ -731,6 +735,30 @@ enum : unsigned {
   GRP_MASKPROC = 0xf0000000
 };
 
+// Compression header for ELF32.
+struct Elf32_Chdr {
+  Elf32_Word ch_type;      // Compression algorithm (ELFCOMPRESS_*)
+  Elf32_Word ch_size;      // Size of the uncompressed data, in bytes
+  Elf32_Word ch_addralign; // Alignment of the uncompressed data
+};
+
+// Compression header for ELF64.
+struct Elf64_Chdr {
+  Elf64_Word  ch_type;
+  Elf64_Word  ch_reserved;
+  Elf64_Xword ch_size;
+  Elf64_Xword ch_addralign;
+};
+
+// Compression algorithms.
+enum {
+  ELFCOMPRESS_ZLIB   = 1,          // zlib deflate, in the zlib format
+  ELFCOMPRESS_LOOS   = 0x60000000, // Operating system-specific range
+  ELFCOMPRESS_HIOS   = 0x6fffffff,
+  ELFCOMPRESS_LOPROC = 0x70000000, // Processor-specific range
+  ELFCOMPRESS_HIPROC = 0x7fffffff
+};
+
 // Symbol table entries for ELF32.
 struct Elf32_Sym {
   Elf32_Word    st_name;  // Symbol name (index into string table)
@@ -35,6 +35,7 @@
 
 namespace llvm {
 class StringRef;
+class raw_ostream;
 
 namespace sys {
 
@@ -52,6 +53,22 @@ public:
   /// allocated space.
   static size_t GetMallocUsage();
 
+  /// \brief Return the peak resident set size of the process, in bytes.
+  /// Unlike GetMallocUsage, this counts every page the process ever had
+  /// mapped in (code, stacks, file mappings, allocator overhead) and never
+  /// decreases. Returns 0 if the operating system doesn't provide it.
+  static size_t GetPeakMemoryUsage();
+
+  /// \brief Return the current resident set size of the process, in bytes.
+  /// Unlike GetPeakMemoryUsage, this goes down when memory is given back to
+  /// the operating system. Returns 0 if the operating system doesn't provide
+  /// it.
+  static size_t GetResidentMemoryUsage();
+
+  /// \brief Print the current and peak resident set size of the process to
+  /// \p OS, as "rss=<N>MB peak-rss=<N>MB" followed by a newline.
+  static void PrintMemoryUsage(raw_ostream &OS);
+
   /// This static function will set \p user_time to the amount of CPU time
   /// spent in user (non-kernel) mode and \p sys_time to the amount of CPU
   /// time spent in system (kernel) mode.  If the operating system does not
@@ -0,0 +1,157 @@
+//===-- llvm/Support/ThreadPool.h - A ThreadPool implementation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a crude C++11 based thread pool, shared by the parts of
+// LLVM that want to run independent pieces of work concurrently.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADPOOL_H
+#define LLVM_SUPPORT_THREADPOOL_H
+
+#include "llvm/Config/llvm-config.h"
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#if LLVM_ENABLE_THREADS
+#include <thread>
+#endif
+
+namespace llvm {
+
+/// A ThreadPool for asynchronous parallel execution on a defined number of
+/// threads.
+///
+/// The pool keeps a vector of threads alive, waiting on a condition variable
+/// for some work to become available. Tasks are queued in FIFO order and
+/// picked up by the first idle worker.
+///
+/// When LLVM is built without thread support, tasks are deferred and run on
+/// the calling thread, either when wait() is called or when the future
+/// returned by async() is waited on.
+class ThreadPool {
+public:
+  typedef std::function<void()> TaskTy;
+  typedef std::packaged_task<void()> PackagedTaskTy;
+
+  /// Construct a pool using getDefaultConcurrency() threads.
+  ThreadPool();
+
+  /// Construct a pool of \p ThreadCount threads. A count of zero is treated
+  /// as one.
+  explicit ThreadPool(unsigned ThreadCount);
+
+  /// Blocking destructor: the pool waits for all the threads to complete.
+  ~ThreadPool();
+
+  /// Asynchronous submission of a task to the pool. The returned future can
+  /// be used to wait for the task to finish and is *non-blocking* on
+  /// destruction.
+  template <typename Function, typename... Args>
+  std::shared_future<void> async(Function &&F, Args &&... ArgList) {
+    auto Task =
+        std::bind(std::forward<Function>(F), std::forward<Args>(ArgList)...);
+    return asyncImpl(std::move(Task));
+  }
+
+  /// Asynchronous submission of a task to the pool. The returned future can
+  /// be used to wait for the task to finish and is *non-blocking* on
+  /// destruction.
+  template <typename Function>
+  std::shared_future<void> async(Function &&F) {
+    return asyncImpl(std::forward<Function>(F));
+  }
+
+  /// Blocking wait for all the threads to complete and the queue to be empty.
+  /// It is an error to try to add new tasks while blocking on this call.
+  void wait();
+
+  /// Returns the number of worker threads owned by this pool.
+  unsigned getThreadCount() const { return ThreadCount; }
+
+  /// Returns the number of threads a default-constructed pool uses: the value
+  /// of the -threads option if it was given, otherwise the number of hardware
+  /// threads available, and always 1 when LLVM is built without threads.
+  static unsigned getDefaultConcurrency();
+
+private:
+  /// Asynchronous submission of a task to the pool. The returned future can
+  /// be used to wait for the task to finish and is *non-blocking* on
+  /// destruction.
+  std::shared_future<void> asyncImpl(TaskTy F);
+
+  unsigned ThreadCount;
+
+  /// Tasks waiting for execution in the pool.
+  std::queue<PackagedTaskTy> Tasks;
+
+  /// Locking and signaling for accessing the Tasks queue.
+  std::mutex QueueLock;
+  std::condition_variable QueueCondition;
+
+  /// Signaling for job completion, guarded by QueueLock.
+  std::condition_variable CompletionCondition;
+
+#if LLVM_ENABLE_THREADS
+  /// Threads in flight.
+  std::vector<std::thread> Threads;
+
+  /// Keep track of the number of thread actually busy, guarded by QueueLock.
+  unsigned ActiveThreads;
+
+  /// Signal for the destruction of the pool, asking thread to exit.
+  bool EnableFlag;
+#endif
+};
+
+/// A set of tasks submitted to a shared ThreadPool that can be waited on
+/// independently from the other work in the pool.
+///
+/// This allows several clients to share one pool (and thus one set of
+/// threads) while each still gets a "wait for my work" barrier.
+class ThreadPoolTaskGroup {
+public:
+  explicit ThreadPoolTaskGroup(ThreadPool &Pool) : Pool(Pool) {}
+
+  /// Waits for the tasks of this group before returning.
+  ~ThreadPoolTaskGroup() { wait(); }
+
+  /// Submit a task to the underlying pool as part of this group.
+  template <typename Function, typename... Args>
+  std::shared_future<void> async(Function &&F, Args &&... ArgList) {
+    std::shared_future<void> Future =
+        Pool.async(std::forward<Function>(F), std::forward<Args>(ArgList)...);
+    std::lock_guard<std::mutex> Lock(FuturesLock);
+    Futures.push_back(Future);
+    return Future;
+  }
+
+  /// Blocking wait for the tasks submitted through this group. Tasks queued
+  /// by other clients of the pool are not waited on. This must not be called
+  /// from a task running on the same pool, as it would hold a worker thread.
+  void wait();
+
+  ThreadPool &getPool() { return Pool; }
+
+private:
+  ThreadPool &Pool;
+  std::mutex FuturesLock;
+  std::vector<std::shared_future<void>> Futures;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_THREADPOOL_H
@@ -77,11 +77,13 @@ namespace llvm {
           DisableTailCalls(false), StackAlignmentOverride(0),
           EnableFastISel(false), PositionIndependentExecutable(false),
           UseInitArray(false), DisableIntegratedAS(false),
-          CompressDebugSections(false), FunctionSections(false),
-          DataSections(false), UniqueSectionNames(true), TrapUnreachable(false),
+          ParallelObjectWriting(false), FastStringTables(false),
+          FunctionSections(false), DataSections(false),
+          UniqueSectionNames(true), TrapUnreachable(false),
           TrapFuncName(), FloatABIType(FloatABI::Default),
           AllowFPOpFusion(FPOpFusion::Standard), JTType(JumpTable::Single),
           FCFI(false), ThreadModel(ThreadModel::POSIX),
+          CompressDebugSections(DebugCompression::None),
           CFIType(CFIntegrity::Sub), CFIEnforcing(false), CFIFuncName() {}
 
     /// PrintMachineCode - This flag is enabled when the -print-machineinstrs
@@ -189,8 +191,13 @@ namespace llvm {
     /// Disable the integrated assembler.
     unsigned DisableIntegratedAS : 1;
 
-    /// Compress DWARF debug sections.
-    unsigned CompressDebugSections : 1;
+    /// Write the sections of object files on several threads. This buffers
+    /// the object file in memory, see MCAsmInfo::ParallelObjectWriting.
+    unsigned ParallelObjectWriting : 1;
+
+    /// Don't merge string suffixes in the string tables of object files, see
+    /// MCAsmInfo::FastStringTables.
+    unsigned FastStringTables : 1;
 
     /// Emit functions into separate sections.
     unsigned FunctionSections : 1;
@@ -247,6 +254,9 @@ namespace llvm {
     /// for things like atomics
     ThreadModel::Model ThreadModel;
 
+    /// CompressDebugSections - How to compress DWARF debug sections.
+    DebugCompression::Type CompressDebugSections;
+
     /// CFIType - This flag specifies the type of control-flow integrity check
     /// to add as a preamble to indirect calls.
     CFIntegrity CFIType;
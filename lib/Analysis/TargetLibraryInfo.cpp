@@ -800,6 +800,10 @@ TargetLibraryInfoWrapperPass::TargetLibraryInfoWrapperPass(
   initializeTargetLibraryInfoWrapperPassPass(*PassRegistry::getPassRegistry());
 }
 
+Pass *TargetLibraryInfoWrapperPass::createReplica() const {
+  return new TargetLibraryInfoWrapperPass(TLIImpl);
+}
+
 char TargetLibraryAnalysis::PassID;
 
 // Register the basic pass.
@@ -14,9 +14,12 @@
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
 
 using namespace llvm;
 
@@ -300,11 +303,25 @@ TargetTransformInfoWrapperPass::TargetTransformInfoWrapperPass(
       *PassRegistry::getPassRegistry());
 }
 
+/// Serializes building TTI for functions of a context that is being
+/// transformed on several threads; target machines cache their per-function
+/// subtargets without a lock of their own.
+static ManagedStatic<sys::SmartMutex<true>> TTIBuildLock;
+
 TargetTransformInfo &TargetTransformInfoWrapperPass::getTTI(Function &F) {
-  TTI = TIRA.run(F);
+  if (F.getContext().hasConcurrentUniquing()) {
+    sys::SmartScopedLock<true> Lock(*TTIBuildLock);
+    TTI = TIRA.run(F);
+  } else {
+    TTI = TIRA.run(F);
+  }
   return *TTI;
 }
 
+Pass *TargetTransformInfoWrapperPass::createReplica() const {
+  return new TargetTransformInfoWrapperPass(TIRA);
+}
+
 ImmutablePass *
 llvm::createTargetTransformInfoWrapperPass(TargetIRAnalysis TIRA) {
   return new TargetTransformInfoWrapperPass(std::move(TIRA));
@@ -76,19 +76,25 @@ static DiagnosticHandlerFunction getDiagHandler(DiagnosticHandlerFunction F,
 }
 
 BitcodeReader::BitcodeReader(MemoryBuffer *buffer, LLVMContext &C,
-                             DiagnosticHandlerFunction DiagnosticHandler)
+                             DiagnosticHandlerFunction DiagnosticHandler,
+                             bool ShouldLazyLoadMetadata)
     : Context(C), DiagnosticHandler(getDiagHandler(DiagnosticHandler, C)),
       TheModule(nullptr), Buffer(buffer), LazyStreamer(nullptr),
       NextUnreadBit(0), SeenValueSymbolTable(false), ValueList(C),
-      MDValueList(C), SeenFirstFunctionBody(false), UseRelativeIDs(false),
+      MDValueList(C), SeenFirstFunctionBody(false),
+      ShouldLazyLoadMetadata(ShouldLazyLoadMetadata),
+      IsMetadataMaterialized(false), UseRelativeIDs(false),
       WillMaterializeAllForwardRefs(false) {}
 
 BitcodeReader::BitcodeReader(DataStreamer *streamer, LLVMContext &C,
-                             DiagnosticHandlerFunction DiagnosticHandler)
+                             DiagnosticHandlerFunction DiagnosticHandler,
+                             bool ShouldLazyLoadMetadata)
     : Context(C), DiagnosticHandler(getDiagHandler(DiagnosticHandler, C)),
       TheModule(nullptr), Buffer(nullptr), LazyStreamer(streamer),
       NextUnreadBit(0), SeenValueSymbolTable(false), ValueList(C),
-      MDValueList(C), SeenFirstFunctionBody(false), UseRelativeIDs(false),
+      MDValueList(C), SeenFirstFunctionBody(false),
+      ShouldLazyLoadMetadata(ShouldLazyLoadMetadata),
+      IsMetadataMaterialized(false), UseRelativeIDs(false),
       WillMaterializeAllForwardRefs(false) {}
 
 std::error_code BitcodeReader::materializeForwardReferencedFunctions() {
@@ -2255,6 +2261,20 @@ std::error_code BitcodeReader::RememberAndSkipFunctionBody() {
   return std::error_code();
 }
 
+/// RememberAndSkipMetadata - When lazily loading metadata, remember where a
+/// module-level metadata block is and then skip it. It is read back by
+/// materializeMetadata().
+std::error_code BitcodeReader::RememberAndSkipMetadata() {
+  // Save the current stream state.
+  uint64_t CurBit = Stream.GetCurrentBitNo();
+  DeferredMetadataInfo.push_back(CurBit);
+
+  // Skip over the block for now.
+  if (Stream.SkipBlock())
+    return Error("Invalid record");
+  return std::error_code();
+}
+
 std::error_code BitcodeReader::GlobalCleanup() {
   // Patch the initializers for globals and aliases up.
   ResolveGlobalAndAliasInits();
@@ -2338,6 +2358,12 @@ std::error_code BitcodeReader::ParseModule(bool Resume) {
           return EC;
         break;
       case bitc::METADATA_BLOCK_ID:
+        if (ShouldLazyLoadMetadata && !IsMetadataMaterialized) {
+          if (std::error_code EC = RememberAndSkipMetadata())
+            return EC;
+          break;
+        }
+        assert(DeferredMetadataInfo.empty() && "Unexpected deferred metadata");
         if (std::error_code EC = ParseMetadata())
           return EC;
         break;
@@ -3895,6 +3921,11 @@ std::error_code BitcodeReader::materialize(GlobalValue *GV) {
   if (!F || !F->isMaterializable())
     return std::error_code();
 
+  // Function bodies refer to module-level metadata by ID, so it has to be in
+  // place before any of them is parsed.
+  if (std::error_code EC = materializeMetadata())
+    return EC;
+
   DenseMap<Function*, uint64_t>::iterator DFII = DeferredFunctionInfo.find(F);
   assert(DFII != DeferredFunctionInfo.end() && "Deferred function not found!");
   // If its position is recorded as 0, its body is somewhere in the stream
@@ -3957,6 +3988,9 @@ std::error_code BitcodeReader::MaterializeModule(Module *M) {
   assert(M == TheModule &&
          "Can only Materialize the Module this BitcodeReader is attached to.");
 
+  if (std::error_code EC = materializeMetadata())
+    return EC;
+
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
@@ -4004,6 +4038,18 @@ std::error_code BitcodeReader::MaterializeModule(Module *M) {
   return std::error_code();
 }
 
+std::error_code BitcodeReader::materializeMetadata() {
+  for (uint64_t BitPos : DeferredMetadataInfo) {
+    // Move the bit stream to the saved position.
+    Stream.JumpToBit(BitPos);
+    if (std::error_code EC = ParseMetadata())
+      return EC;
+  }
+  DeferredMetadataInfo.clear();
+  IsMetadataMaterialized = true;
+  return std::error_code();
+}
+
 std::vector<StructType *> BitcodeReader::getIdentifiedStructTypes() const {
   return IdentifiedStructTypes;
 }
@@ -4097,10 +4143,11 @@ const std::error_category &llvm::BitcodeErrorCategory() {
 static ErrorOr<Module *>
 getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
                          LLVMContext &Context, bool WillMaterializeAll,
-                         DiagnosticHandlerFunction DiagnosticHandler) {
+                         DiagnosticHandlerFunction DiagnosticHandler,
+                         bool ShouldLazyLoadMetadata = false) {
   Module *M = new Module(Buffer->getBufferIdentifier(), Context);
-  BitcodeReader *R =
-      new BitcodeReader(Buffer.get(), Context, DiagnosticHandler);
+  BitcodeReader *R = new BitcodeReader(Buffer.get(), Context, DiagnosticHandler,
+                                       ShouldLazyLoadMetadata);
   M->setMaterializer(R);
 
   auto cleanupOnError = [&](std::error_code EC) {
@@ -4124,9 +4171,10 @@ getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
 ErrorOr<Module *>
 llvm::getLazyBitcodeModule(std::unique_ptr<MemoryBuffer> &&Buffer,
                            LLVMContext &Context,
-                           DiagnosticHandlerFunction DiagnosticHandler) {
+                           DiagnosticHandlerFunction DiagnosticHandler,
+                           bool ShouldLazyLoadMetadata) {
   return getLazyBitcodeModuleImpl(std::move(Buffer), Context, false,
-                                  DiagnosticHandler);
+                                  DiagnosticHandler, ShouldLazyLoadMetadata);
 }
 
 ErrorOr<std::unique_ptr<Module>>
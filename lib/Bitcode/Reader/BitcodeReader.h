@@ -190,6 +190,18 @@ class BitcodeReader : public GVMaterializer {
   /// stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// When module-level metadata is loaded lazily, the positions of the
+  /// skipped METADATA_BLOCKs in the stream, in the order they were seen.
+  std::vector<uint64_t> DeferredMetadataInfo;
+
+  /// True if module-level metadata blocks should be skipped while parsing the
+  /// module and only read when materializeMetadata() is called (explicitly,
+  /// or before the first function body is materialized).
+  bool ShouldLazyLoadMetadata;
+
+  /// True once the deferred module-level metadata has been read.
+  bool IsMetadataMaterialized;
+
   /// These are basic blocks forward-referenced by block addresses.  They are
   /// inserted lazily into functions when they're loaded.  The basic block ID is
   /// its index into the vector.
@@ -218,9 +230,11 @@ public:
   std::error_code Error(const Twine &Message);
 
   explicit BitcodeReader(MemoryBuffer *buffer, LLVMContext &C,
-                         DiagnosticHandlerFunction DiagnosticHandler);
+                         DiagnosticHandlerFunction DiagnosticHandler,
+                         bool ShouldLazyLoadMetadata = false);
   explicit BitcodeReader(DataStreamer *streamer, LLVMContext &C,
-                         DiagnosticHandlerFunction DiagnosticHandler);
+                         DiagnosticHandlerFunction DiagnosticHandler,
+                         bool ShouldLazyLoadMetadata = false);
   ~BitcodeReader() { FreeState(); }
 
   std::error_code materializeForwardReferencedFunctions();
@@ -232,6 +246,7 @@ public:
   bool isDematerializable(const GlobalValue *GV) const override;
   std::error_code materialize(GlobalValue *GV) override;
   std::error_code MaterializeModule(Module *M) override;
+  std::error_code materializeMetadata() override;
   std::vector<StructType *> getIdentifiedStructTypes() const override;
   void Dematerialize(GlobalValue *GV) override;
 
@@ -349,6 +364,7 @@ private:
   std::error_code ParseValueSymbolTable();
   std::error_code ParseConstants();
   std::error_code RememberAndSkipFunctionBody();
+  std::error_code RememberAndSkipMetadata();
   std::error_code ParseFunctionBody(Function *F);
   std::error_code GlobalCleanup();
   std::error_code ResolveGlobalAndAliasInits();
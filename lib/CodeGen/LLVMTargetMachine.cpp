@@ -60,8 +60,14 @@ void LLVMTargetMachine::initAsmInfo() {
   if (Options.DisableIntegratedAS)
     TmpAsmInfo->setUseIntegratedAssembler(false);
 
-  if (Options.CompressDebugSections)
-    TmpAsmInfo->setCompressDebugSections(true);
+  if (Options.CompressDebugSections != DebugCompression::None)
+    TmpAsmInfo->setCompressDebugSections(Options.CompressDebugSections);
+
+  if (Options.ParallelObjectWriting)
+    TmpAsmInfo->setParallelObjectWriting(true);
+
+  if (Options.FastStringTables)
+    TmpAsmInfo->setFastStringTables(true);
 
   AsmInfo = TmpAsmInfo;
 }
@@ -0,0 +1,112 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+
+using namespace llvm;
+
+static bool codegen(Module &M, raw_ostream &OS, const Target *TheTarget,
+                    StringRef CPU, StringRef Features,
+                    const TargetOptions &Options, Reloc::Model RM,
+                    CodeModel::Model CM, CodeGenOpt::Level OL,
+                    TargetMachine::CodeGenFileType FileType) {
+  std::unique_ptr<TargetMachine> TM(TheTarget->createTargetMachine(
+      M.getTargetTriple(), CPU, Features, Options, RM, CM, OL));
+
+  legacy::PassManager CodeGenPasses;
+  if (const DataLayout *DL = TM->getDataLayout())
+    M.setDataLayout(DL);
+  CodeGenPasses.add(new DataLayoutPass());
+
+  formatted_raw_ostream FOS(OS);
+  if (TM->addPassesToEmitFile(CodeGenPasses, FOS, FileType))
+    return false;
+
+  CodeGenPasses.run(M);
+  return true;
+}
+
+bool llvm::splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs, StringRef CPU,
+                        StringRef Features, const TargetOptions &Options,
+                        std::string &ErrMsg, Reloc::Model RM,
+                        CodeModel::Model CM, CodeGenOpt::Level OL,
+                        TargetMachine::CodeGenFileType FileType) {
+  assert(!OSs.empty() && "No output streams given");
+
+  StringRef TripleStr = M.getTargetTriple();
+  const Target *TheTarget = TargetRegistry::lookupTarget(TripleStr, ErrMsg);
+  if (!TheTarget)
+    return false;
+
+  if (OSs.size() == 1) {
+    if (codegen(M, *OSs[0], TheTarget, CPU, Features, Options, RM, CM, OL,
+                FileType))
+      return true;
+    ErrMsg = "target file type not supported";
+    return false;
+  }
+
+  // An LLVMContext is not thread safe, so each partition is code generated
+  // in a context of its own. The partitions are serialized to bitcode on this
+  // thread (the source context is only ever touched from here) and parsed
+  // back into a fresh context by the worker that owns it.
+  std::vector<SmallVector<char, 0>> Bitcodes;
+  Bitcodes.reserve(OSs.size());
+  SplitModule(M, OSs.size(), [&](std::unique_ptr<Module> MPart) {
+    Bitcodes.emplace_back();
+    raw_svector_ostream BCOS(Bitcodes.back());
+    WriteBitcodeToFile(MPart.get(), BCOS);
+    BCOS.flush();
+  });
+
+  // The per-partition results are only written by their own worker.
+  std::unique_ptr<bool[]> Succeeded(new bool[OSs.size()]);
+  {
+    ThreadPool Pool(OSs.size());
+    for (unsigned I = 0, E = OSs.size(); I != E; ++I) {
+      Pool.async([&, I] {
+        const SmallVector<char, 0> &BC = Bitcodes[I];
+        LLVMContext Ctx;
+        ErrorOr<Module *> MOrErr = parseBitcodeFile(
+            MemoryBufferRef(StringRef(BC.data(), BC.size()), "<split-module>"),
+            Ctx);
+        if (!MOrErr)
+          report_fatal_error("Failed to read bitcode");
+        std::unique_ptr<Module> MPart(MOrErr.get());
+        Succeeded[I] = codegen(*MPart, *OSs[I], TheTarget, CPU, Features,
+                               Options, RM, CM, OL, FileType);
+      });
+    }
+    Pool.wait();
+  }
+
+  for (unsigned I = 0, E = OSs.size(); I != E; ++I) {
+    if (!Succeeded[I]) {
+      ErrMsg = "target file type not supported";
+      return false;
+    }
+  }
+  return true;
+}
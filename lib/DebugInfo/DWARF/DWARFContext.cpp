@@ -12,12 +12,15 @@
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/DebugInfo/DWARF/DWARFAcceleratorTable.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugArangeSet.h"
+#include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <tuple>
 using namespace llvm;
 using namespace dwarf;
 using namespace object;
@@ -322,23 +325,61 @@ const DWARFDebugFrame *DWARFContext::getDebugFrame() {
 
 const DWARFLineTable *
 DWARFContext::getLineTableForUnit(DWARFUnit *cu) {
-  if (!Line)
-    Line.reset(new DWARFDebugLine(&getLineSection().Relocs));
-
   unsigned stmtOffset =
       cu->getCompileUnitDIE()->getAttributeValueAsSectionOffset(
           cu, DW_AT_stmt_list, -1U);
   if (stmtOffset == -1U)
     return nullptr; // No line table for this compile unit.
 
-  // See if the line table is cached.
-  if (const DWARFLineTable *lt = Line->getLineTable(stmtOffset))
-    return lt;
+  {
+    std::lock_guard<std::mutex> Lock(LineTableMutex);
+    if (!Line)
+      Line.reset(new DWARFDebugLine(&getLineSection().Relocs));
+
+    // See if the line table is cached.
+    if (const DWARFLineTable *lt = Line->getLineTable(stmtOffset))
+      return lt;
+  }
 
-  // We have to parse it first.
+  // We have to parse it first. Do it outside of the lock so that other units
+  // can have their tables parsed at the same time.
   DataExtractor lineData(getLineSection().Data, isLittleEndian(),
                          cu->getAddressByteSize());
-  return Line->getOrParseLineTable(lineData, stmtOffset);
+  DWARFLineTable LT;
+  uint32_t Offset = stmtOffset;
+  bool Parsed = LT.parse(lineData, &getLineSection().Relocs, &Offset);
+
+  std::lock_guard<std::mutex> Lock(LineTableMutex);
+  const DWARFLineTable *lt = Line->insertLineTable(stmtOffset, std::move(LT));
+  return Parsed ? lt : nullptr;
+}
+
+void DWARFContext::preloadUnits(ThreadPool &Pool) {
+  // The unit headers and the abbreviations they share are read serially,
+  // everything that belongs to a single unit is extracted concurrently.
+  parseCompileUnits();
+  // With a limit on the resident units, only preload as many as can stay
+  // resident. The others would only be released again.
+  size_t NumPreloaded = CUs.size();
+  if (MaxResidentUnits)
+    NumPreloaded = std::min<size_t>(NumPreloaded, MaxResidentUnits);
+  {
+    ThreadPoolTaskGroup Group(Pool);
+    for (size_t I = 0; I != NumPreloaded; ++I) {
+      DWARFCompileUnit *U = CUs[I].get();
+      Group.async([this, U] {
+        U->buildAddressIndex();
+        getLineTableForUnit(U);
+      });
+    }
+  }
+  for (size_t I = 0; I != NumPreloaded; ++I)
+    touchUnit(CUs[I].get());
+
+  if (!Aranges) {
+    Aranges.reset(new DWARFDebugAranges());
+    Aranges->generate(this, &Pool);
+  }
 }
 
 void DWARFContext::parseCompileUnits() {
@@ -376,7 +417,48 @@ DWARFCompileUnit *DWARFContext::getCompileUnitForAddress(uint64_t Address) {
   // First, get the offset of the compile unit.
   uint32_t CUOffset = getDebugAranges()->findAddress(Address);
   // Retrieve the compile unit.
-  return getCompileUnitForOffset(CUOffset);
+  DWARFCompileUnit *CU = getCompileUnitForOffset(CUOffset);
+  if (CU)
+    touchUnit(CU);
+  return CU;
+}
+
+void DWARFContext::setMaxResidentUnits(unsigned N) {
+  MaxResidentUnits = N;
+  if (!N) {
+    ResidentUnits.clear();
+    ResidentUnitIndex.clear();
+  }
+}
+
+void DWARFContext::touchUnit(DWARFCompileUnit *CU) {
+  if (!MaxResidentUnits)
+    return;
+  auto I = ResidentUnitIndex.find(CU);
+  if (I != ResidentUnitIndex.end()) {
+    // Already resident, just move it to the back.
+    ResidentUnits.splice(ResidentUnits.end(), ResidentUnits, I->second);
+    return;
+  }
+  ResidentUnitIndex[CU] = ResidentUnits.insert(ResidentUnits.end(), CU);
+  while (ResidentUnits.size() > MaxResidentUnits) {
+    DWARFCompileUnit *Evicted = ResidentUnits.front();
+    releaseUnit(Evicted);
+    ResidentUnitIndex.erase(Evicted);
+    ResidentUnits.pop_front();
+  }
+}
+
+void DWARFContext::releaseUnit(DWARFCompileUnit *CU) {
+  unsigned StmtOffset =
+      CU->getCompileUnitDIE()->getAttributeValueAsSectionOffset(
+          CU, DW_AT_stmt_list, -1U);
+  if (StmtOffset != -1U) {
+    std::lock_guard<std::mutex> Lock(LineTableMutex);
+    if (Line)
+      Line->eraseLineTable(StmtOffset);
+  }
+  CU->releaseDIEs();
 }
 
 static bool getFunctionNameForAddress(DWARFCompileUnit *CU, uint64_t Address,
@@ -521,6 +603,7 @@ DWARFContext::getInliningInfoForAddress(uint64_t Address,
   return InliningInfo;
 }
 
+// Consume the header of a .zdebug_* section.
 static bool consumeCompressedDebugSectionHeader(StringRef &data,
                                                 uint64_t &OriginalSize) {
   // Consume "ZLIB" prefix.
@@ -537,9 +620,89 @@ static bool consumeCompressedDebugSectionHeader(StringRef &data,
   return true;
 }
 
+// Consume the Elf32/64_Chdr at the start of a SHF_COMPRESSED section.
+static bool consumeCompressionHeader(const object::ObjectFile &Obj,
+                                     StringRef &Data, uint64_t &OriginalSize) {
+  bool Is64Bit = Obj.getBytesInAddress() == 8;
+  DataExtractor Extractor(Data, Obj.isLittleEndian(), 0);
+  uint32_t Offset = 0;
+  if (!Extractor.isValidOffsetForDataOfSize(
+          0, Is64Bit ? sizeof(ELF::Elf64_Chdr) : sizeof(ELF::Elf32_Chdr)))
+    return false;
+  if (Extractor.getU32(&Offset) != ELF::ELFCOMPRESS_ZLIB)
+    return false;
+  if (Is64Bit) {
+    Extractor.getU32(&Offset); // ch_reserved
+    OriginalSize = Extractor.getU64(&Offset);
+    Extractor.getU64(&Offset); // ch_addralign
+  } else {
+    OriginalSize = Extractor.getU32(&Offset);
+    Extractor.getU32(&Offset); // ch_addralign
+  }
+  Data = Data.substr(Offset);
+  return true;
+}
+
+// If Section is compressed, either as a .zdebug_* section or as a
+// SHF_COMPRESSED section, consume its compression header from Data and return
+// true. Name is the section name without its leading dots.
+static bool consumeCompressionHeader(const object::ObjectFile &Obj,
+                                     const SectionRef &Section, StringRef Name,
+                                     StringRef &Data, uint64_t &OriginalSize,
+                                     bool &IsCompressed) {
+  IsCompressed = false;
+  if (Name.startswith("zdebug_")) {
+    IsCompressed = true;
+    return consumeCompressedDebugSectionHeader(Data, OriginalSize);
+  }
+  auto *ELFObj = dyn_cast<object::ELFObjectFileBase>(&Obj);
+  if (ELFObj && (ELFObj->getSectionFlags(Section) & ELF::SHF_COMPRESSED)) {
+    IsCompressed = true;
+    return consumeCompressionHeader(Obj, Data, OriginalSize);
+  }
+  return true;
+}
+
+// Return the size of the contents of Section once they are decompressed.
+static uint64_t getUncompressedSize(const object::ObjectFile &Obj,
+                                    const SectionRef &Section) {
+  StringRef Name;
+  Section.getName(Name);
+  Name = Name.substr(Name.find_first_not_of("._"));
+  StringRef Data;
+  Section.getContents(Data);
+  uint64_t OriginalSize;
+  bool IsCompressed;
+  if (consumeCompressionHeader(Obj, Section, Name, Data, OriginalSize,
+                               IsCompressed) &&
+      IsCompressed)
+    return OriginalSize;
+  return Section.getSize();
+}
+
+void DWARFContextInMemory::decompress(StringRef &Data) {
+  auto I = CompressedSectionMap.find(&Data);
+  if (I == CompressedSectionMap.end())
+    return;
+  CompressedSection &C = *I->second;
+  std::call_once(C.Decompressed, [&C] {
+    // A section that can't be decompressed is left empty.
+    if (zlib::uncompress(C.Data, C.Uncompressed, C.OriginalSize) !=
+        zlib::StatusOK)
+      C.Uncompressed.clear();
+    for (StringRef *Contents : C.Contents)
+      *Contents = C.Uncompressed;
+  });
+}
+
 DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
     : IsLittleEndian(Obj.isLittleEndian()),
       AddressSize(Obj.getBytesInAddress()) {
+  // The debug_types sections are found by section, their contents only have a
+  // stable address once all of them have been added.
+  std::vector<std::tuple<TypeSectionMap *, SectionRef, CompressedSection *>>
+      CompressedTypesSections;
+
   for (const SectionRef &Section : Obj.sections()) {
     StringRef name;
     Section.getName(name);
@@ -555,21 +718,24 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
 
     name = name.substr(name.find_first_not_of("._")); // Skip . and _ prefixes.
 
-    // Check if debug info section is compressed with zlib.
-    if (name.startswith("zdebug_")) {
-      uint64_t OriginalSize;
-      if (!zlib::isAvailable() ||
-          !consumeCompressedDebugSectionHeader(data, OriginalSize))
-        continue;
-      UncompressedSections.resize(UncompressedSections.size() + 1);
-      if (zlib::uncompress(data, UncompressedSections.back(), OriginalSize) !=
-          zlib::StatusOK) {
-        UncompressedSections.pop_back();
+    // Check if debug info section is compressed with zlib. It is only
+    // decompressed when it is used.
+    uint64_t OriginalSize;
+    bool IsCompressed;
+    if (!consumeCompressionHeader(Obj, Section, name, data, OriginalSize,
+                                  IsCompressed))
+      continue;
+    CompressedSection *Compressed = nullptr;
+    if (IsCompressed) {
+      if (!zlib::isAvailable())
         continue;
-      }
-      // Make data point to uncompressed section contents and save its contents.
-      name = name.substr(1);
-      data = UncompressedSections.back();
+      CompressedSections.emplace_back();
+      Compressed = &CompressedSections.back();
+      Compressed->Data = data;
+      Compressed->OriginalSize = OriginalSize;
+      if (name.startswith("zdebug_"))
+        name = name.substr(1);
+      data = StringRef();
     }
 
     StringRef *SectionData =
@@ -602,16 +768,26 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
             .Default(nullptr);
     if (SectionData) {
       *SectionData = data;
+      if (Compressed)
+        Compressed->Contents.push_back(SectionData);
       if (name == "debug_ranges") {
         // FIXME: Use the other dwo range section when we emit it.
         RangeDWOSection = data;
+        if (Compressed)
+          Compressed->Contents.push_back(&RangeDWOSection);
       }
     } else if (name == "debug_types") {
       // Find debug_types data by section rather than name as there are
       // multiple, comdat grouped, debug_types sections.
       TypesSections[Section].Data = data;
+      if (Compressed)
+        CompressedTypesSections.emplace_back(&TypesSections, Section,
+                                             Compressed);
     } else if (name == "debug_types.dwo") {
       TypesDWOSections[Section].Data = data;
+      if (Compressed)
+        CompressedTypesSections.emplace_back(&TypesDWOSections, Section,
+                                             Compressed);
     }
 
     section_iterator RelocatedSection = Section.getRelocatedSection();
@@ -622,6 +798,8 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
     RelocatedSection->getName(RelSecName);
     RelSecName = RelSecName.substr(
         RelSecName.find_first_not_of("._")); // Skip . and _ prefixes.
+    if (RelSecName.startswith("zdebug_"))
+      RelSecName = RelSecName.substr(1);
 
     // TODO: Add support for relocations in other sections as needed.
     // Record relocations for the debug_info and debug_line sections.
@@ -648,7 +826,7 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
     }
 
     if (Section.relocation_begin() != Section.relocation_end()) {
-      uint64_t SectionSize = RelocatedSection->getSize();
+      uint64_t SectionSize = getUncompressedSize(Obj, *RelocatedSection);
       for (const RelocationRef &Reloc : Section.relocations()) {
         uint64_t Address;
         Reloc.getOffset(Address);
@@ -691,6 +869,12 @@ DWARFContextInMemory::DWARFContextInMemory(const object::ObjectFile &Obj)
       }
     }
   }
+
+  for (const auto &I : CompressedTypesSections)
+    std::get<2>(I)->Contents.push_back(&(*std::get<0>(I))[std::get<1>(I)].Data);
+  for (CompressedSection &C : CompressedSections)
+    for (StringRef *Contents : C.Contents)
+      CompressedSectionMap[Contents] = &C;
 }
 
 void DWARFContextInMemory::anchor() { }
@@ -12,6 +12,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugArangeSet.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -35,7 +36,7 @@ void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
   }
 }
 
-void DWARFDebugAranges::generate(DWARFContext *CTX) {
+void DWARFDebugAranges::generate(DWARFContext *CTX, ThreadPool *Pool) {
   clear();
   if (!CTX)
     return;
@@ -47,17 +48,29 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
-  for (const auto &CU : CTX->compile_units()) {
-    uint32_t CUOffset = CU->getOffset();
-    if (ParsedCUOffsets.insert(CUOffset).second) {
-      DWARFAddressRangesVector CURanges;
-      CU->collectAddressRanges(CURanges);
-      for (const auto &R : CURanges) {
-        appendRange(CUOffset, R.first, R.second);
-      }
-    }
+  std::vector<DWARFCompileUnit *> CUs;
+  for (const auto &CU : CTX->compile_units())
+    if (ParsedCUOffsets.insert(CU->getOffset()).second)
+      CUs.push_back(CU.get());
+
+  // Each unit only touches its own DIEs, so the units can be walked
+  // concurrently as long as the ranges are appended in a fixed order.
+  std::vector<DWARFAddressRangesVector> CURanges(CUs.size());
+  if (Pool) {
+    ThreadPoolTaskGroup Group(*Pool);
+    for (size_t I = 0, E = CUs.size(); I != E; ++I)
+      Group.async([&CUs, &CURanges, I] {
+        CUs[I]->collectAddressRanges(CURanges[I]);
+      });
+  } else {
+    for (size_t I = 0, E = CUs.size(); I != E; ++I)
+      CUs[I]->collectAddressRanges(CURanges[I]);
   }
 
+  for (size_t I = 0, E = CUs.size(); I != E; ++I)
+    for (const auto &R : CURanges[I])
+      appendRange(CUs[I]->getOffset(), R.first, R.second);
+
   construct();
 }
 
@@ -244,6 +244,12 @@ DWARFDebugLine::getOrParseLineTable(DataExtractor debug_line_data,
   return LT;
 }
 
+const DWARFDebugLine::LineTable *
+DWARFDebugLine::insertLineTable(uint32_t offset, LineTable &&LT) {
+  return &LineTableMap.insert(
+      LineTableMapTy::value_type(offset, std::move(LT))).first->second;
+}
+
 bool DWARFDebugLine::LineTable::parse(DataExtractor debug_line_data,
                                       const RelocAddrMap *RMap,
                                       uint32_t *offset_ptr) {
@@ -533,16 +539,17 @@ uint32_t DWARFDebugLine::LineTable::lookupAddress(uint64_t address) const {
   SequenceIter last_seq = Sequences.end();
   SequenceIter seq_pos = std::lower_bound(first_seq, last_seq, sequence,
       DWARFDebugLine::Sequence::orderByLowPC);
-  DWARFDebugLine::Sequence found_seq;
+  SequenceIter found_pos;
   if (seq_pos == last_seq) {
-    found_seq = Sequences.back();
+    found_pos = last_seq - 1;
   } else if (seq_pos->LowPC == address) {
-    found_seq = *seq_pos;
+    found_pos = seq_pos;
   } else {
     if (seq_pos == first_seq)
       return unknown_index;
-    found_seq = *(seq_pos - 1);
+    found_pos = seq_pos - 1;
   }
+  const DWARFDebugLine::Sequence &found_seq = *found_pos;
   if (!found_seq.containsPC(address))
     return unknown_index;
   // Search for instruction address in the rows describing the sequence.
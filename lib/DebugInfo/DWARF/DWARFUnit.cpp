@@ -12,7 +12,9 @@
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <cstdio>
+#include <set>
 
 using namespace llvm;
 using namespace dwarf;
@@ -121,6 +123,9 @@ void DWARFUnit::clear() {
   AddrOffsetSectionBase = 0;
   clearDIEs(false);
   DWO.reset();
+  AddressIndexEntries.clear();
+  AddressIndexSegments.clear();
+  AddressIndexBuilt = false;
 }
 
 const char *DWARFUnit::getCompilationDir() {
@@ -230,6 +235,12 @@ size_t DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
   if (DieArray.empty())
     return 0;
 
+  // The reservation made while extracting is only a guess based on the size
+  // of the unit. Units stay resident for a long time in the symbolizer, so
+  // give back the excess when it is significant.
+  if (DieArray.capacity() - DieArray.size() > DieArray.size() / 8)
+    DieArray.shrink_to_fit();
+
   // If CU DIE was just parsed, copy several attribute values from it.
   if (!HasCUDie) {
     uint64_t BaseAddr =
@@ -309,6 +320,11 @@ void DWARFUnit::clearDIEs(bool KeepCUDie) {
   }
 }
 
+void DWARFUnit::releaseDIEs() {
+  clearDIEs(true);
+  DWO.reset();
+}
+
 void DWARFUnit::collectAddressRanges(DWARFAddressRangesVector &CURanges) {
   // First, check if CU DIE describes address ranges for the unit.
   const auto &CUDIERanges = getCompileUnitDIE()->getAddressRanges(this);
@@ -339,39 +355,126 @@ void DWARFUnit::collectAddressRanges(DWARFAddressRangesVector &CURanges) {
     clearDIEs(true);
 }
 
-const DWARFDebugInfoEntryMinimal *
-DWARFUnit::getSubprogramForAddress(uint64_t Address) {
+void DWARFUnit::buildAddressIndex() {
+  if (AddressIndexBuilt)
+    return;
+  AddressIndexBuilt = true;
   extractDIEsIfNeeded(false);
-  for (const DWARFDebugInfoEntryMinimal &DIE : DieArray) {
-    if (DIE.isSubprogramDIE() &&
-        DIE.addressRangeContainsAddress(this, Address)) {
-      return &DIE;
+
+  struct Endpoint {
+    uint64_t Address;
+    uint32_t Entry;
+    bool IsStart;
+  };
+  std::vector<Endpoint> Endpoints;
+
+  // Walk the DIEs in order, keeping track of the closest enclosing entry of
+  // each DIE that has children. NULL entries close the innermost scope.
+  SmallVector<uint32_t, 16> Scopes;
+  for (uint32_t I = 0, E = DieArray.size(); I != E; ++I) {
+    const DWARFDebugInfoEntryMinimal &DIE = DieArray[I];
+    if (DIE.isNULL()) {
+      if (!Scopes.empty())
+        Scopes.pop_back();
+      continue;
+    }
+    uint32_t Enclosing = Scopes.empty() ? -1U : Scopes.back();
+    uint32_t Current = Enclosing;
+    if (DIE.isSubroutineDIE()) {
+      DWARFAddressRangesVector Ranges = DIE.getAddressRanges(this);
+      if (!Ranges.empty()) {
+        Current = AddressIndexEntries.size();
+        AddressIndexEntries.push_back({I, Enclosing});
+        for (const auto &R : Ranges) {
+          if (R.first >= R.second)
+            continue;
+          Endpoints.push_back({R.first, Current, true});
+          Endpoints.push_back({R.second, Current, false});
+        }
+      }
     }
+    if (DIE.hasChildren())
+      Scopes.push_back(Current);
   }
-  return nullptr;
+
+  // Split the address space into segments covered by the same entries, and
+  // give each the innermost entry of its chain. The chain is the one a walk of
+  // the DIE tree finds: the root is the first subprogram in DIE order that
+  // covers the segment, even if identical code folding made other subprograms
+  // cover it too. The chain then descends through the first inlined
+  // subroutine at each level that covers the segment as well.
+  std::sort(Endpoints.begin(), Endpoints.end(),
+            [](const Endpoint &LHS, const Endpoint &RHS) {
+              return LHS.Address < RHS.Address;
+            });
+  std::multiset<uint32_t> Active;
+  for (size_t I = 0, E = Endpoints.size(); I != E;) {
+    uint64_t Address = Endpoints[I].Address;
+    for (; I != E && Endpoints[I].Address == Address; ++I) {
+      if (Endpoints[I].IsStart)
+        Active.insert(Endpoints[I].Entry);
+      else
+        Active.erase(Active.find(Endpoints[I].Entry));
+    }
+    uint32_t Entry = -1U;
+    for (uint32_t Candidate : Active) {
+      const DWARFDebugInfoEntryMinimal &DIE =
+          DieArray[AddressIndexEntries[Candidate].DIEIndex];
+      if (Entry == -1U) {
+        if (DIE.isSubprogramDIE())
+          Entry = Candidate;
+      } else if (AddressIndexEntries[Candidate].Parent == Entry &&
+                 DIE.getTag() == dwarf::DW_TAG_inlined_subroutine) {
+        Entry = Candidate;
+      }
+    }
+    if (AddressIndexSegments.empty() ||
+        AddressIndexSegments.back().Entry != Entry)
+      AddressIndexSegments.push_back({Address, Entry});
+  }
+  AddressIndexSegments.shrink_to_fit();
+}
+
+uint32_t DWARFUnit::lookupAddressIndex(uint64_t Address) {
+  buildAddressIndex();
+  auto It = std::upper_bound(
+      AddressIndexSegments.begin(), AddressIndexSegments.end(), Address,
+      [](uint64_t Address, const AddressIndexSegment &Segment) {
+        return Address < Segment.Address;
+      });
+  if (It == AddressIndexSegments.begin())
+    return -1U;
+  return std::prev(It)->Entry;
 }
 
 DWARFDebugInfoEntryInlinedChain
 DWARFUnit::getInlinedChainForAddress(uint64_t Address) {
-  // First, find a subprogram that contains the given address (the root
-  // of inlined chain).
-  const DWARFUnit *ChainCU = nullptr;
-  const DWARFDebugInfoEntryMinimal *SubprogramDIE =
-      getSubprogramForAddress(Address);
-  if (SubprogramDIE) {
-    ChainCU = this;
-  } else {
+  // First, find the innermost subroutine that contains the given address.
+  DWARFUnit *ChainCU = this;
+  uint32_t Entry = lookupAddressIndex(Address);
+  if (Entry == -1U) {
     // Try to look for subprogram DIEs in the DWO file.
     parseDWO();
     if (DWO.get()) {
-      SubprogramDIE = DWO->getUnit()->getSubprogramForAddress(Address);
-      if (SubprogramDIE)
-        ChainCU = DWO->getUnit();
+      ChainCU = DWO->getUnit();
+      Entry = ChainCU->lookupAddressIndex(Address);
     }
   }
 
-  // Get inlined chain rooted at this subprogram DIE.
-  if (!SubprogramDIE)
-    return DWARFDebugInfoEntryInlinedChain();
-  return SubprogramDIE->getInlinedChainForAddress(ChainCU, Address);
+  // Then walk up the enclosing inlined subroutines, which all cover the
+  // address, to the subprogram at the root of the chain, which comes last.
+  // Subprograms nested in the DIE of another function are not part of it.
+  DWARFDebugInfoEntryInlinedChain InlinedChain;
+  if (Entry == -1U)
+    return InlinedChain;
+  ChainCU->extractDIEsIfNeeded(false);
+  InlinedChain.U = ChainCU;
+  for (; Entry != -1U; Entry = ChainCU->AddressIndexEntries[Entry].Parent) {
+    const DWARFDebugInfoEntryMinimal &DIE =
+        ChainCU->DieArray[ChainCU->AddressIndexEntries[Entry].DIEIndex];
+    InlinedChain.DIEs.push_back(DIE);
+    if (DIE.isSubprogramDIE())
+      break;
+  }
+  return InlinedChain;
 }
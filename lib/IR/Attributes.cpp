@@ -38,6 +38,7 @@ Attribute Attribute::get(LLVMContext &Context, Attribute::AttrKind Kind,
   ID.AddInteger(Kind);
   if (Val) ID.AddInteger(Val);
 
+  UniquingLock Guard(pImpl, pImpl->AttributesLock);
   void *InsertPoint;
   AttributeImpl *PA = pImpl->AttrsSet.FindNodeOrInsertPos(ID, InsertPoint);
 
@@ -61,6 +62,7 @@ Attribute Attribute::get(LLVMContext &Context, StringRef Kind, StringRef Val) {
   ID.AddString(Kind);
   if (!Val.empty()) ID.AddString(Val);
 
+  UniquingLock Guard(pImpl, pImpl->AttributesLock);
   void *InsertPoint;
   AttributeImpl *PA = pImpl->AttrsSet.FindNodeOrInsertPos(ID, InsertPoint);
 
@@ -452,6 +454,7 @@ AttributeSetNode *AttributeSetNode::get(LLVMContext &C,
          E = SortedAttrs.end(); I != E; ++I)
     I->Profile(ID);
 
+  UniquingLock Guard(pImpl, pImpl->AttributesLock);
   void *InsertPoint;
   AttributeSetNode *PA =
     pImpl->AttrsSetNodes.FindNodeOrInsertPos(ID, InsertPoint);
@@ -579,6 +582,7 @@ AttributeSet::getImpl(LLVMContext &C,
   FoldingSetNodeID ID;
   AttributeSetImpl::Profile(ID, Attrs);
 
+  UniquingLock Guard(pImpl, pImpl->AttributesLock);
   void *InsertPoint;
   AttributeSetImpl *PA = pImpl->AttrsLists.FindNodeOrInsertPos(ID, InsertPoint);
 
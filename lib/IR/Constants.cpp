@@ -518,6 +518,7 @@ ConstantInt::ConstantInt(IntegerType *Ty, const APInt& V)
 
 ConstantInt *ConstantInt::getTrue(LLVMContext &Context) {
   LLVMContextImpl *pImpl = Context.pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   if (!pImpl->TheTrueVal)
     pImpl->TheTrueVal = ConstantInt::get(Type::getInt1Ty(Context), 1);
   return pImpl->TheTrueVal;
@@ -525,6 +526,7 @@ ConstantInt *ConstantInt::getTrue(LLVMContext &Context) {
 
 ConstantInt *ConstantInt::getFalse(LLVMContext &Context) {
   LLVMContextImpl *pImpl = Context.pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   if (!pImpl->TheFalseVal)
     pImpl->TheFalseVal = ConstantInt::get(Type::getInt1Ty(Context), 0);
   return pImpl->TheFalseVal;
@@ -558,6 +560,7 @@ Constant *ConstantInt::getFalse(Type *Ty) {
 ConstantInt *ConstantInt::get(LLVMContext &Context, const APInt &V) {
   // get an existing value or the insertion position
   LLVMContextImpl *pImpl = Context.pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   ConstantInt *&Slot = pImpl->IntConstants[V];
   if (!Slot) {
     // Get the corresponding integer type for the bit width of the value.
@@ -687,6 +690,7 @@ Constant *ConstantFP::getZeroValueForNegation(Type *Ty) {
 ConstantFP* ConstantFP::get(LLVMContext &Context, const APFloat& V) {
   LLVMContextImpl* pImpl = Context.pImpl;
 
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   ConstantFP *&Slot = pImpl->FPConstants[V];
 
   if (!Slot) {
@@ -841,7 +845,9 @@ ConstantArray::ConstantArray(ArrayType *T, ArrayRef<Constant *> V)
 Constant *ConstantArray::get(ArrayType *Ty, ArrayRef<Constant*> V) {
   if (Constant *C = getImpl(Ty, V))
     return C;
-  return Ty->getContext().pImpl->ArrayConstants.getOrCreate(Ty, V);
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  return pImpl->ArrayConstants.getOrCreate(Ty, V);
 }
 Constant *ConstantArray::getImpl(ArrayType *Ty, ArrayRef<Constant*> V) {
   // Empty arrays are canonicalized to ConstantAggregateZero.
@@ -998,7 +1004,9 @@ Constant *ConstantStruct::get(StructType *ST, ArrayRef<Constant*> V) {
   if (isUndef)
     return UndefValue::get(ST);
 
-  return ST->getContext().pImpl->StructConstants.getOrCreate(ST, V);
+  LLVMContextImpl *pImpl = ST->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  return pImpl->StructConstants.getOrCreate(ST, V);
 }
 
 Constant *ConstantStruct::get(StructType *T, ...) {
@@ -1026,7 +1034,9 @@ Constant *ConstantVector::get(ArrayRef<Constant*> V) {
   if (Constant *C = getImpl(V))
     return C;
   VectorType *Ty = VectorType::get(V.front()->getType(), V.size());
-  return Ty->getContext().pImpl->VectorConstants.getOrCreate(Ty, V);
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  return pImpl->VectorConstants.getOrCreate(Ty, V);
 }
 Constant *ConstantVector::getImpl(ArrayRef<Constant*> V) {
   assert(!V.empty() && "Vectors can't be empty");
@@ -1348,7 +1358,9 @@ ConstantAggregateZero *ConstantAggregateZero::get(Type *Ty) {
   assert((Ty->isStructTy() || Ty->isArrayTy() || Ty->isVectorTy()) &&
          "Cannot create an aggregate zero of non-aggregate type!");
   
-  ConstantAggregateZero *&Entry = Ty->getContext().pImpl->CAZConstants[Ty];
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  ConstantAggregateZero *&Entry = pImpl->CAZConstants[Ty];
   if (!Entry)
     Entry = new ConstantAggregateZero(Ty);
 
@@ -1358,14 +1370,21 @@ ConstantAggregateZero *ConstantAggregateZero::get(Type *Ty) {
 /// destroyConstant - Remove the constant from the constant table.
 ///
 void ConstantAggregateZero::destroyConstant() {
-  getContext().pImpl->CAZConstants.erase(getType());
+  {
+    UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
+    getContext().pImpl->CAZConstants.erase(getType());
+  }
   destroyConstantImpl();
 }
 
 /// destroyConstant - Remove the constant from the constant table...
 ///
 void ConstantArray::destroyConstant() {
-  getType()->getContext().pImpl->ArrayConstants.remove(this);
+  {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+    pImpl->ArrayConstants.remove(this);
+  }
   destroyConstantImpl();
 }
 
@@ -1376,14 +1395,22 @@ void ConstantArray::destroyConstant() {
 // destroyConstant - Remove the constant from the constant table...
 //
 void ConstantStruct::destroyConstant() {
-  getType()->getContext().pImpl->StructConstants.remove(this);
+  {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+    pImpl->StructConstants.remove(this);
+  }
   destroyConstantImpl();
 }
 
 // destroyConstant - Remove the constant from the constant table...
 //
 void ConstantVector::destroyConstant() {
-  getType()->getContext().pImpl->VectorConstants.remove(this);
+  {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+    pImpl->VectorConstants.remove(this);
+  }
   destroyConstantImpl();
 }
 
@@ -1428,7 +1455,9 @@ const APInt &Constant::getUniqueInteger() const {
 //
 
 ConstantPointerNull *ConstantPointerNull::get(PointerType *Ty) {
-  ConstantPointerNull *&Entry = Ty->getContext().pImpl->CPNConstants[Ty];
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  ConstantPointerNull *&Entry = pImpl->CPNConstants[Ty];
   if (!Entry)
     Entry = new ConstantPointerNull(Ty);
 
@@ -1438,7 +1467,10 @@ ConstantPointerNull *ConstantPointerNull::get(PointerType *Ty) {
 // destroyConstant - Remove the constant from the constant table...
 //
 void ConstantPointerNull::destroyConstant() {
-  getContext().pImpl->CPNConstants.erase(getType());
+  {
+    UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
+    getContext().pImpl->CPNConstants.erase(getType());
+  }
   // Free the constant and any dangling references to it.
   destroyConstantImpl();
 }
@@ -1448,7 +1480,9 @@ void ConstantPointerNull::destroyConstant() {
 //
 
 UndefValue *UndefValue::get(Type *Ty) {
-  UndefValue *&Entry = Ty->getContext().pImpl->UVConstants[Ty];
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  UndefValue *&Entry = pImpl->UVConstants[Ty];
   if (!Entry)
     Entry = new UndefValue(Ty);
 
@@ -1459,7 +1493,10 @@ UndefValue *UndefValue::get(Type *Ty) {
 //
 void UndefValue::destroyConstant() {
   // Free the constant and any dangling references to it.
-  getContext().pImpl->UVConstants.erase(getType());
+  {
+    UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
+    getContext().pImpl->UVConstants.erase(getType());
+  }
   destroyConstantImpl();
 }
 
@@ -1472,8 +1509,9 @@ BlockAddress *BlockAddress::get(BasicBlock *BB) {
 }
 
 BlockAddress *BlockAddress::get(Function *F, BasicBlock *BB) {
-  BlockAddress *&BA =
-    F->getContext().pImpl->BlockAddresses[std::make_pair(F, BB)];
+  LLVMContextImpl *pImpl = F->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  BlockAddress *&BA = pImpl->BlockAddresses[std::make_pair(F, BB)];
   if (!BA)
     BA = new BlockAddress(F, BB);
 
@@ -1495,8 +1533,9 @@ BlockAddress *BlockAddress::lookup(const BasicBlock *BB) {
 
   const Function *F = BB->getParent();
   assert(F && "Block must have a parent");
-  BlockAddress *BA =
-      F->getContext().pImpl->BlockAddresses.lookup(std::make_pair(F, BB));
+  LLVMContextImpl *pImpl = F->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+  BlockAddress *BA = pImpl->BlockAddresses.lookup(std::make_pair(F, BB));
   assert(BA && "Refcount and block address map disagree!");
   return BA;
 }
@@ -1504,8 +1543,12 @@ BlockAddress *BlockAddress::lookup(const BasicBlock *BB) {
 // destroyConstant - Remove the constant from the constant table.
 //
 void BlockAddress::destroyConstant() {
-  getFunction()->getType()->getContext().pImpl
-    ->BlockAddresses.erase(std::make_pair(getFunction(), getBasicBlock()));
+  {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+    pImpl->BlockAddresses.erase(
+        std::make_pair(getFunction(), getBasicBlock()));
+  }
   getBasicBlock()->AdjustBlockAddressRefCount(-1);
   destroyConstantImpl();
 }
@@ -1523,6 +1566,7 @@ void BlockAddress::replaceUsesOfWithOnConstant(Value *From, Value *To, Use *U) {
 
   // See if the 'new' entry already exists, if not, just update this in place
   // and return early.
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
   BlockAddress *&NewBA =
     getContext().pImpl->BlockAddresses[std::make_pair(NewF, NewBB)];
   if (NewBA) {
@@ -1562,6 +1606,7 @@ static Constant *getFoldedCast(Instruction::CastOps opc, Constant *C, Type *Ty,
   // Look up the constant in the table first to ensure uniqueness.
   ConstantExprKeyType Key(opc, C);
 
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(Ty, Key);
 }
 
@@ -1919,6 +1964,7 @@ Constant *ConstantExpr::get(unsigned Opcode, Constant *C1, Constant *C2,
   ConstantExprKeyType Key(Opcode, ArgVec, 0, Flags);
 
   LLVMContextImpl *pImpl = C1->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(C1->getType(), Key);
 }
 
@@ -2000,6 +2046,7 @@ Constant *ConstantExpr::getSelect(Constant *C, Constant *V1, Constant *V2,
   ConstantExprKeyType Key(Instruction::Select, ArgVec);
 
   LLVMContextImpl *pImpl = C->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(V1->getType(), Key);
 }
 
@@ -2039,6 +2086,7 @@ Constant *ConstantExpr::getGetElementPtr(Constant *C, ArrayRef<Value *> Idxs,
                                 InBounds ? GEPOperator::IsInBounds : 0);
 
   LLVMContextImpl *pImpl = C->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(ReqTy, Key);
 }
 
@@ -2064,6 +2112,7 @@ Constant *ConstantExpr::getICmp(unsigned short pred, Constant *LHS,
     ResultTy = VectorType::get(ResultTy, VT->getNumElements());
 
   LLVMContextImpl *pImpl = LHS->getType()->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(ResultTy, Key);
 }
 
@@ -2088,6 +2137,7 @@ Constant *ConstantExpr::getFCmp(unsigned short pred, Constant *LHS,
     ResultTy = VectorType::get(ResultTy, VT->getNumElements());
 
   LLVMContextImpl *pImpl = LHS->getType()->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(ResultTy, Key);
 }
 
@@ -2110,6 +2160,7 @@ Constant *ConstantExpr::getExtractElement(Constant *Val, Constant *Idx,
   const ConstantExprKeyType Key(Instruction::ExtractElement, ArgVec);
 
   LLVMContextImpl *pImpl = Val->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(ReqTy, Key);
 }
 
@@ -2133,6 +2184,7 @@ Constant *ConstantExpr::getInsertElement(Constant *Val, Constant *Elt,
   const ConstantExprKeyType Key(Instruction::InsertElement, ArgVec);
 
   LLVMContextImpl *pImpl = Val->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(Val->getType(), Key);
 }
 
@@ -2156,6 +2208,7 @@ Constant *ConstantExpr::getShuffleVector(Constant *V1, Constant *V2,
   const ConstantExprKeyType Key(Instruction::ShuffleVector, ArgVec);
 
   LLVMContextImpl *pImpl = ShufTy->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(ShufTy, Key);
 }
 
@@ -2180,6 +2233,7 @@ Constant *ConstantExpr::getInsertValue(Constant *Agg, Constant *Val,
   const ConstantExprKeyType Key(Instruction::InsertValue, ArgVec, 0, 0, Idxs);
 
   LLVMContextImpl *pImpl = Agg->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(ReqTy, Key);
 }
 
@@ -2204,6 +2258,7 @@ Constant *ConstantExpr::getExtractValue(Constant *Agg, ArrayRef<unsigned> Idxs,
   const ConstantExprKeyType Key(Instruction::ExtractValue, ArgVec, 0, 0, Idxs);
 
   LLVMContextImpl *pImpl = Agg->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->ExprConstants.getOrCreate(ReqTy, Key);
 }
 
@@ -2358,7 +2413,11 @@ Constant *ConstantExpr::getBinOpAbsorber(unsigned Opcode, Type *Ty) {
 // destroyConstant - Remove the constant from the constant table...
 //
 void ConstantExpr::destroyConstant() {
-  getType()->getContext().pImpl->ExprConstants.remove(this);
+  {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+    pImpl->ExprConstants.remove(this);
+  }
   destroyConstantImpl();
 }
 
@@ -2453,6 +2512,8 @@ Constant *ConstantDataSequential::getImpl(StringRef Elements, Type *Ty) {
     return ConstantAggregateZero::get(Ty);
 
   // Do a lookup to see if we have already formed one of these.
+  UniquingLock Guard(Ty->getContext().pImpl,
+                     Ty->getContext().pImpl->ConstantsLock);
   auto &Slot =
       *Ty->getContext()
            .pImpl->CDSConstants.insert(std::make_pair(Elements, nullptr))
@@ -2478,40 +2539,43 @@ Constant *ConstantDataSequential::getImpl(StringRef Elements, Type *Ty) {
 }
 
 void ConstantDataSequential::destroyConstant() {
-  // Remove the constant from the StringMap.
-  StringMap<ConstantDataSequential*> &CDSConstants = 
-    getType()->getContext().pImpl->CDSConstants;
+  {
+    // Remove the constant from the StringMap.
+    UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
+    StringMap<ConstantDataSequential*> &CDSConstants = 
+      getType()->getContext().pImpl->CDSConstants;
 
-  StringMap<ConstantDataSequential*>::iterator Slot =
-    CDSConstants.find(getRawDataValues());
+    StringMap<ConstantDataSequential*>::iterator Slot =
+      CDSConstants.find(getRawDataValues());
 
-  assert(Slot != CDSConstants.end() && "CDS not found in uniquing table");
+    assert(Slot != CDSConstants.end() && "CDS not found in uniquing table");
 
-  ConstantDataSequential **Entry = &Slot->getValue();
+    ConstantDataSequential **Entry = &Slot->getValue();
 
-  // Remove the entry from the hash table.
-  if (!(*Entry)->Next) {
-    // If there is only one value in the bucket (common case) it must be this
-    // entry, and removing the entry should remove the bucket completely.
-    assert((*Entry) == this && "Hash mismatch in ConstantDataSequential");
-    getContext().pImpl->CDSConstants.erase(Slot);
-  } else {
-    // Otherwise, there are multiple entries linked off the bucket, unlink the 
-    // node we care about but keep the bucket around.
-    for (ConstantDataSequential *Node = *Entry; ;
-         Entry = &Node->Next, Node = *Entry) {
-      assert(Node && "Didn't find entry in its uniquing hash table!");
-      // If we found our entry, unlink it from the list and we're done.
-      if (Node == this) {
-        *Entry = Node->Next;
-        break;
+    // Remove the entry from the hash table.
+    if (!(*Entry)->Next) {
+      // If there is only one value in the bucket (common case) it must be this
+      // entry, and removing the entry should remove the bucket completely.
+      assert((*Entry) == this && "Hash mismatch in ConstantDataSequential");
+      getContext().pImpl->CDSConstants.erase(Slot);
+    } else {
+      // Otherwise, there are multiple entries linked off the bucket, unlink the 
+      // node we care about but keep the bucket around.
+      for (ConstantDataSequential *Node = *Entry; ;
+           Entry = &Node->Next, Node = *Entry) {
+        assert(Node && "Didn't find entry in its uniquing hash table!");
+        // If we found our entry, unlink it from the list and we're done.
+        if (Node == this) {
+          *Entry = Node->Next;
+          break;
+        }
       }
     }
-  }
 
-  // If we were part of a list, make sure that we don't delete the list that is
-  // still owned by the uniquing map.
-  Next = nullptr;
+    // If we were part of a list, make sure that we don't delete the list that
+    // is still owned by the uniquing map.
+    Next = nullptr;
+  }
 
   // Finally, actually delete it.
   destroyConstantImpl();
@@ -2859,6 +2923,7 @@ void ConstantArray::replaceUsesOfWithOnConstant(Value *From, Value *To,
   }
 
   // Update to the new value.
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
   if (Constant *C = getContext().pImpl->ArrayConstants.replaceOperandsInPlace(
           Values, this, From, ToC, NumUpdated, U - OperandList))
     replaceUsesOfWithOnConstantImpl(C);
@@ -2909,6 +2974,7 @@ void ConstantStruct::replaceUsesOfWithOnConstant(Value *From, Value *To,
   }
 
   // Update to the new value.
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
   if (Constant *C = getContext().pImpl->StructConstants.replaceOperandsInPlace(
           Values, this, From, ToC))
     replaceUsesOfWithOnConstantImpl(C);
@@ -2937,6 +3003,7 @@ void ConstantVector::replaceUsesOfWithOnConstant(Value *From, Value *To,
   }
 
   // Update to the new value.
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
   if (Constant *C = getContext().pImpl->VectorConstants.replaceOperandsInPlace(
           Values, this, From, ToC, NumUpdated, U - OperandList))
     replaceUsesOfWithOnConstantImpl(C);
@@ -2965,6 +3032,7 @@ void ConstantExpr::replaceUsesOfWithOnConstant(Value *From, Value *ToV,
   }
 
   // Update to the new value.
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->ConstantsLock);
   if (Constant *C = getContext().pImpl->ExprConstants.replaceOperandsInPlace(
           NewOps, this, From, To, NumUpdated, U - OperandList))
     replaceUsesOfWithOnConstantImpl(C);
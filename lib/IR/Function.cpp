@@ -252,8 +252,11 @@ Function::Function(FunctionType *Ty, LinkageTypes Linkage, const Twine &name,
   if (Ty->getNumParams())
     setValueSubclassData(1);   // Set the "has lazy arguments" bit.
 
-  if (ParentModule)
+  if (ParentModule) {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Lock(pImpl, pImpl->ModuleLock);
     ParentModule->getFunctionList().push_back(this);
+  }
 
   // Ensure intrinsics have the right parameter attributes.
   if (unsigned IID = getIntrinsicID())
@@ -272,8 +275,11 @@ Function::~Function() {
   clearGC();
 
   // Remove the intrinsicID from the Cache.
-  if (getValueName() && isIntrinsic())
-    getContext().pImpl->IntrinsicIDCache.erase(this);
+  if (getValueName() && isIntrinsic()) {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Lock(pImpl, pImpl->ModuleLock);
+    pImpl->IntrinsicIDCache.erase(this);
+  }
 }
 
 void Function::BuildLazyArguments() const {
@@ -427,8 +433,10 @@ unsigned Function::getIntrinsicID() const {
   if (!ValName || !isIntrinsic())
     return 0;
 
+  LLVMContextImpl *pImpl = getContext().pImpl;
+  UniquingLock Lock(pImpl, pImpl->ModuleLock);
   LLVMContextImpl::IntrinsicIDCacheTy &IntrinsicIDCache =
-    getContext().pImpl->IntrinsicIDCache;
+    pImpl->IntrinsicIDCache;
   if (!IntrinsicIDCache.count(this)) {
     unsigned Id = lookupIntrinsicID();
     IntrinsicIDCache[this]=Id;
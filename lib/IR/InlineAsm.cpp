@@ -31,6 +31,7 @@ InlineAsm *InlineAsm::get(FunctionType *Ty, StringRef AsmString,
   InlineAsmKeyType Key(AsmString, Constraints, hasSideEffects, isAlignStack,
                        asmDialect);
   LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  UniquingLock Guard(pImpl, pImpl->ConstantsLock);
   return pImpl->InlineAsms.getOrCreate(PointerType::getUnqual(Ty), Key);
 }
 
@@ -48,7 +49,11 @@ InlineAsm::InlineAsm(PointerType *Ty, const std::string &asmString,
 }
 
 void InlineAsm::destroyConstant() {
-  getType()->getContext().pImpl->InlineAsms.remove(this);
+  {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Guard(pImpl, pImpl->ConstantsLock);
+    pImpl->InlineAsms.remove(this);
+  }
   delete this;
 }
 
@@ -31,7 +31,8 @@ LLVMContext& llvm::getGlobalContext() {
   return *GlobalContext;
 }
 
-LLVMContext::LLVMContext() : pImpl(new LLVMContextImpl(*this)) {
+LLVMContext::LLVMContext()
+    : pImpl(new LLVMContextImpl(*this)), ConcurrentUniquing(false) {
   // Create the fixed metadata kinds. This is done in the same order as the
   // MD_* enum values so that they correspond.
 
@@ -94,7 +95,11 @@ LLVMContext::LLVMContext() : pImpl(new LLVMContextImpl(*this)) {
   assert(NonNullID == MD_nonnull && "nonnull kind id drifted");
   (void)NonNullID;
 }
-LLVMContext::~LLVMContext() { delete pImpl; }
+LLVMContext::~LLVMContext() {
+  delete pImpl;
+  if (ConcurrentUniquing)
+    --Use::NumConcurrentContexts;
+}
 
 void LLVMContext::addModule(Module *M) {
   pImpl->OwnedModules.insert(M);
@@ -155,6 +160,18 @@ void LLVMContext::yield() {
     pImpl->YieldCallback(this, pImpl->YieldOpaqueHandle);
 }
 
+void LLVMContext::enableConcurrentUniquing() {
+  if (!ConcurrentUniquing)
+    ++Use::NumConcurrentContexts;
+  ConcurrentUniquing = true;
+}
+
+void LLVMContext::disableConcurrentUniquing() {
+  if (ConcurrentUniquing)
+    --Use::NumConcurrentContexts;
+  ConcurrentUniquing = false;
+}
+
 void LLVMContext::emitError(const Twine &ErrorStr) {
   diagnose(DiagnosticInfoInlineAsm(ErrorStr));
 }
@@ -235,6 +252,7 @@ unsigned LLVMContext::getMDKindID(StringRef Name) const {
          "Named metadata may not start with a digit");
 
   // If this is new, assign it its ID.
+  UniquingLock Guard(pImpl, pImpl->MetadataLock);
   return pImpl->CustomMDKindNames.insert(std::make_pair(
                                              Name,
                                              pImpl->CustomMDKindNames.size()))
@@ -244,6 +262,7 @@ unsigned LLVMContext::getMDKindID(StringRef Name) const {
 /// getHandlerNames - Populate client supplied smallvector using custome
 /// metadata name and ID.
 void LLVMContext::getMDKindNames(SmallVectorImpl<StringRef> &Names) const {
+  UniquingLock Guard(pImpl, pImpl->MetadataLock);
   Names.resize(pImpl->CustomMDKindNames.size());
   for (StringMap<unsigned>::const_iterator I = pImpl->CustomMDKindNames.begin(),
        E = pImpl->CustomMDKindNames.end(); I != E; ++I)
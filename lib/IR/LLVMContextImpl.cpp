@@ -13,14 +13,19 @@
 
 #include "LLVMContextImpl.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Module.h"
 #include <algorithm>
 using namespace llvm;
 
+STATISTIC(NumContendedUniquingLocks,
+          "Number of times a uniquing table was waited for");
+
 LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
-  : TheTrueVal(nullptr), TheFalseVal(nullptr),
+  : ConcurrentUniquing(C.ConcurrentUniquing),
+    TheTrueVal(nullptr), TheFalseVal(nullptr),
     VoidTy(C, Type::VoidTyID),
     LabelTy(C, Type::LabelTyID),
     HalfTy(C, Type::HalfTyID),
@@ -46,6 +51,13 @@ LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
   NamedStructTypesUniqueID = 0;
 }
 
+void LLVMContextImpl::acquireUniquingLock(sys::SmartMutex<true> &Lock) {
+  if (Lock.try_lock())
+    return;
+  ++NumContendedUniquingLocks;
+  Lock.lock();
+}
+
 namespace {
 struct DropReferences {
   // Takes the value_type of a ConstantUniqueMap's internal map, whose 'second'
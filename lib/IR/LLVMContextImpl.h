@@ -32,6 +32,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/Mutex.h"
 #include <vector>
 
 namespace llvm {
@@ -867,6 +868,36 @@ public:
   LLVMContext::YieldCallbackTy YieldCallback;
   void *YieldOpaqueHandle;
 
+  /// \brief Whether the uniquing tables below may be used from several
+  /// threads at once, and are therefore guarded by the locks that follow. See
+  /// LLVMContext::enableConcurrentUniquing(). This is the context's own flag.
+  const bool &ConcurrentUniquing;
+
+  /// \brief Locks for the uniquing tables of a concurrent context, one for
+  /// each family of tables, so that looking up, say, a type doesn't wait for a
+  /// constant being looked up on another thread. They are recursive because
+  /// uniquing one object may unique others of the same family. A thread that
+  /// holds more than one of them took them in this order.
+  sys::SmartMutex<true> ConstantsLock;
+  sys::SmartMutex<true> TypesLock;
+  sys::SmartMutex<true> AttributesLock;
+  sys::SmartMutex<true> MetadataLock;
+
+  /// \brief Lock for the module-level state a function pass may touch in a
+  /// concurrent context: the intrinsic ID cache, and the function and global
+  /// lists and symbol tables of modules. It is taken before any of the
+  /// uniquing locks.
+  sys::SmartMutex<true> ModuleLock;
+
+  /// \brief Lock for ValueHandles in a concurrent context. It is taken after
+  /// any of the uniquing locks, and value handle callbacks run while it is
+  /// held.
+  sys::SmartMutex<true> ValueHandlesLock;
+
+  /// \brief Take one of the locks above, counting the times it was held by
+  /// another thread.
+  static void acquireUniquingLock(sys::SmartMutex<true> &Lock);
+
   typedef DenseMap<APInt, ConstantInt *, DenseMapAPIntKeyInfo> IntMapTy;
   IntMapTy IntConstants;
 
@@ -988,6 +1019,26 @@ public:
   void dropTriviallyDeadConstantArrays();
 };
 
+/// \brief Holds one of the uniquing locks of a context for as long as it
+/// lives, if the context is concurrent; otherwise does nothing.
+class UniquingLock {
+  sys::SmartMutex<true> *Lock;
+
+public:
+  UniquingLock(LLVMContextImpl *pImpl, sys::SmartMutex<true> &Lock)
+      : Lock(pImpl->ConcurrentUniquing ? &Lock : nullptr) {
+    if (this->Lock)
+      LLVMContextImpl::acquireUniquingLock(Lock);
+  }
+  ~UniquingLock() {
+    if (Lock)
+      Lock->unlock();
+  }
+
+  UniquingLock(const UniquingLock &) = delete;
+  void operator=(const UniquingLock &) = delete;
+};
+
 }
 
 #endif
@@ -13,20 +13,27 @@
 
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/LegacyPassManagers.h"
 #include "llvm/IR/LegacyPassNameParser.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <map>
 using namespace llvm;
 using namespace llvm::legacy;
@@ -498,7 +505,7 @@ static TimingInfo *TheTimeInfo;
 // PMTopLevelManager implementation
 
 /// Initialize top level manager. Create first pass manager.
-PMTopLevelManager::PMTopLevelManager(PMDataManager *PMDM) {
+PMTopLevelManager::PMTopLevelManager(PMDataManager *PMDM) : NumThreads(1) {
   PMDM->setTopLevelManager(this);
   addPassManager(PMDM);
   activeStack.push(PMDM);
@@ -804,6 +811,18 @@ void PMTopLevelManager::initializeAllAnalysisInfo() {
   }
 }
 
+void PMTopLevelManager::setNumThreads(unsigned N) {
+  if (N != NumThreads)
+    Pool.reset();
+  NumThreads = N;
+}
+
+ThreadPool &PMTopLevelManager::getThreadPool() {
+  if (!Pool)
+    Pool.reset(new ThreadPool(NumThreads));
+  return *Pool;
+}
+
 /// Destructor
 PMTopLevelManager::~PMTopLevelManager() {
   for (SmallVectorImpl<PMDataManager *>::iterator I = PassManagers.begin(),
@@ -1554,12 +1573,203 @@ bool FPPassManager::runOnFunction(Function &F) {
 bool FPPassManager::runOnModule(Module &M) {
   bool Changed = false;
 
+  if (TPM->getNumThreads() > 1 && runOnModuleInParallel(M, Changed))
+    return Changed;
+
   for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
     Changed |= runOnFunction(*I);
 
   return Changed;
 }
 
+/// Appends the global values in NewGlobals that C refers to, directly or through
+/// other constants, to Order, in the order they are first seen.
+static void collectNewGlobals(const Constant *C,
+                              SmallPtrSetImpl<const Constant *> &Visited,
+                              SmallPtrSetImpl<GlobalValue *> &NewGlobals,
+                              std::vector<GlobalValue *> &Order) {
+  if (!isa<GlobalValue>(C) && !C->getNumOperands())
+    return;
+  if (!Visited.insert(C).second)
+    return;
+  if (auto *GV = dyn_cast<GlobalValue>(const_cast<Constant *>(C))) {
+    if (!NewGlobals.erase(GV))
+      return;
+    Order.push_back(GV);
+  }
+  for (const Use &Op : C->operands())
+    collectNewGlobals(cast<Constant>(Op.get()), Visited, NewGlobals, Order);
+}
+
+/// Gives the global values that function passes added to M on several threads
+/// the order and names they would get if the functions had been run in order.
+///
+/// Library call simplification, for instance, adds declarations and private
+/// string constants. Where they end up in the module lists depends on which
+/// thread got to them first, and so do the numbers that make the names of the
+/// string constants unique. They are moved to the end of their lists in the
+/// order the functions first use them, and the new globals with local linkage
+/// are renamed in that order. UniquedNames holds the length of the name a
+/// global asked for if the symbol table had to add a suffix to it.
+static void
+orderNewGlobals(Module &M, const DenseSet<const GlobalValue *> &OldGlobals,
+                const DenseMap<const Value *, unsigned> &UniquedNames) {
+  SmallPtrSet<GlobalValue *, 16> NewGlobals;
+  for (GlobalVariable &GV : M.globals())
+    if (!OldGlobals.count(&GV))
+      NewGlobals.insert(&GV);
+  for (Function &F : M)
+    if (!OldGlobals.count(&F))
+      NewGlobals.insert(&F);
+  for (GlobalAlias &GA : M.aliases())
+    if (!OldGlobals.count(&GA))
+      NewGlobals.insert(&GA);
+  if (NewGlobals.empty())
+    return;
+
+  std::vector<GlobalValue *> Order;
+  SmallPtrSet<const Constant *, 64> Visited;
+  for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB)
+        for (const Use &Op : I.operands())
+          if (auto *C = dyn_cast_or_null<Constant>(Op.get()))
+            collectNewGlobals(C, Visited, NewGlobals, Order);
+
+  // Whatever no function uses is dropped if it is local to the module, and
+  // otherwise goes last, ordered by its (unique) name.
+  std::vector<GlobalValue *> Unused;
+  for (GlobalValue *GV : NewGlobals) {
+    if (GV->hasLocalLinkage() && GV->use_empty())
+      GV->eraseFromParent();
+    else
+      Unused.push_back(GV);
+  }
+  std::sort(Unused.begin(), Unused.end(),
+            [](const GlobalValue *L, const GlobalValue *R) {
+              return L->getName() < R->getName();
+            });
+  Order.insert(Order.end(), Unused.begin(), Unused.end());
+
+  // Take the names of the local globals away first, so that renaming one in
+  // order doesn't collide with the name another got on its thread.
+  std::vector<std::pair<GlobalValue *, std::string>> Renamed;
+  for (GlobalValue *GV : Order) {
+    if (auto *F = dyn_cast<Function>(GV))
+      M.getFunctionList().splice(M.end(), M.getFunctionList(), F);
+    else if (auto *GVar = dyn_cast<GlobalVariable>(GV))
+      M.getGlobalList().splice(M.global_end(), M.getGlobalList(), GVar);
+    else
+      M.getAliasList().splice(M.alias_end(), M.getAliasList(),
+                              cast<GlobalAlias>(GV));
+    if (GV->hasLocalLinkage() && GV->hasName()) {
+      StringRef Name = GV->getName();
+      auto Uniqued = UniquedNames.find(GV);
+      if (Uniqued != UniquedNames.end())
+        Name = Name.substr(0, Uniqued->second);
+      Renamed.push_back(std::make_pair(GV, Name.str()));
+      GV->setName("");
+    }
+  }
+  // Make the names unique with a counter of our own, since the one in the
+  // module's symbol table was bumped on whatever threads had collisions.
+  StringMap<unsigned> NextSuffix;
+  for (auto &GVAndName : Renamed) {
+    const std::string &Base = GVAndName.second;
+    std::string Name = Base;
+    unsigned &Suffix = NextSuffix[Base];
+    while (M.getNamedValue(Name))
+      Name = Base + utostr(++Suffix);
+    GVAndName.first->setName(Name);
+  }
+}
+
+bool FPPassManager::runOnModuleInParallel(Module &M, bool &Changed) {
+  std::vector<Function *> Functions;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+
+  unsigned NumThreads =
+      std::min<size_t>(TPM->getNumThreads(), Functions.size());
+  if (NumThreads < 2)
+    return false;
+
+  // Each thread gets a function pass manager of its own, with replicas of the
+  // immutable passes and of the transformations in this manager. The
+  // analyses are scheduled anew for the transformations that require them.
+  std::vector<std::unique_ptr<FunctionPassManagerImpl>> Replicas;
+  for (unsigned I = 0; I != NumThreads; ++I) {
+    std::unique_ptr<FunctionPassManagerImpl> Replica(
+        new FunctionPassManagerImpl());
+    Replica->setTopLevelManager(Replica.get());
+    Replica->setResolver(new AnalysisResolver(*Replica));
+    for (ImmutablePass *IP : TPM->getImmutablePasses()) {
+      Pass *P = IP->createReplica();
+      if (!P) {
+        const PassInfo *PI = TPM->findAnalysisPassInfo(IP->getPassID());
+        if (!PI || !PI->getNormalCtor())
+          return false;
+        P = PI->createPass();
+      }
+      Replica->add(P);
+    }
+    for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
+      FunctionPass *FP = getContainedPass(Index);
+      const PassInfo *PI = TPM->findAnalysisPassInfo(FP->getPassID());
+      if (PI && PI->isAnalysis())
+        continue;
+      Pass *P = FP->createReplica();
+      if (!P)
+        return false;
+      Replica->add(P);
+    }
+    Replicas.push_back(std::move(Replica));
+  }
+
+  DenseSet<const GlobalValue *> OldGlobals;
+  for (const GlobalValue &GV : M.globals())
+    OldGlobals.insert(&GV);
+  for (const GlobalValue &GV : M)
+    OldGlobals.insert(&GV);
+  for (const GlobalValue &GV : M.aliases())
+    OldGlobals.insert(&GV);
+
+  // The context only needs to be concurrent while the replicas run, unless its
+  // owner shares it between threads anyway.
+  LLVMContext &Context = M.getContext();
+  bool WasConcurrent = Context.hasConcurrentUniquing();
+  Context.enableConcurrentUniquing();
+  DenseMap<const Value *, unsigned> UniquedNames;
+  M.getValueSymbolTable().setUniquedNameLog(&UniquedNames);
+  for (auto &Replica : Replicas)
+    Changed |= Replica->doInitialization(M);
+
+  // Hand out the functions one at a time, so that a thread that got small
+  // functions goes on to the next one instead of leaving the others to wait.
+  std::atomic<size_t> NextFunction(0);
+  std::vector<char> ReplicaChanged(NumThreads, false);
+  ThreadPool &Pool = TPM->getThreadPool();
+  for (unsigned I = 0; I != NumThreads; ++I)
+    Pool.async([&, I] {
+      for (size_t N = NextFunction++; N < Functions.size(); N = NextFunction++)
+        if (Replicas[I]->run(*Functions[N]))
+          ReplicaChanged[I] = true;
+    });
+  Pool.wait();
+  M.getValueSymbolTable().setUniquedNameLog(nullptr);
+  if (!WasConcurrent)
+    Context.disableConcurrentUniquing();
+  orderNewGlobals(M, OldGlobals, UniquedNames);
+
+  // The replicas are not finalized. Module-level finalization, such as the
+  // verifier's check of the whole module, runs once, on the passes of this
+  // manager.
+  for (unsigned I = 0; I != NumThreads; ++I)
+    Changed |= ReplicaChanged[I];
+  return true;
+}
+
 bool FPPassManager::doInitialization(Module &M) {
   bool Changed = false;
 
@@ -1756,6 +1966,10 @@ bool PassManager::run(Module &M) {
   return PM->run(M);
 }
 
+void PassManager::setNumThreads(unsigned N) {
+  PM->setNumThreads(N);
+}
+
 //===----------------------------------------------------------------------===//
 // TimingInfo implementation
 
@@ -35,6 +35,7 @@ MetadataAsValue::MetadataAsValue(Type *Ty, Metadata *MD)
 }
 
 MetadataAsValue::~MetadataAsValue() {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   getType()->getContext().pImpl->MetadataAsValues.erase(MD);
   untrack();
 }
@@ -73,6 +74,7 @@ static Metadata *canonicalizeMetadataForValue(LLVMContext &Context,
 }
 
 MetadataAsValue *MetadataAsValue::get(LLVMContext &Context, Metadata *MD) {
+  UniquingLock Guard(Context.pImpl, Context.pImpl->MetadataLock);
   MD = canonicalizeMetadataForValue(Context, MD);
   auto *&Entry = Context.pImpl->MetadataAsValues[MD];
   if (!Entry)
@@ -82,12 +84,14 @@ MetadataAsValue *MetadataAsValue::get(LLVMContext &Context, Metadata *MD) {
 
 MetadataAsValue *MetadataAsValue::getIfExists(LLVMContext &Context,
                                               Metadata *MD) {
+  UniquingLock Guard(Context.pImpl, Context.pImpl->MetadataLock);
   MD = canonicalizeMetadataForValue(Context, MD);
   auto &Store = Context.pImpl->MetadataAsValues;
   return Store.lookup(MD);
 }
 
 void MetadataAsValue::handleChangedMetadata(Metadata *MD) {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   LLVMContext &Context = getContext();
   MD = canonicalizeMetadataForValue(Context, MD);
   auto &Store = Context.pImpl->MetadataAsValues;
@@ -250,6 +254,8 @@ static Function *getLocalFunction(Value *V) {
 
 ValueAsMetadata *ValueAsMetadata::get(Value *V) {
   assert(V && "Unexpected null Value");
+  UniquingLock Guard(V->getContext().pImpl,
+                     V->getContext().pImpl->MetadataLock);
 
   auto &Context = V->getContext();
   auto *&Entry = Context.pImpl->ValuesAsMetadata[V];
@@ -270,11 +276,15 @@ ValueAsMetadata *ValueAsMetadata::get(Value *V) {
 
 ValueAsMetadata *ValueAsMetadata::getIfExists(Value *V) {
   assert(V && "Unexpected null Value");
+  UniquingLock Guard(V->getContext().pImpl,
+                     V->getContext().pImpl->MetadataLock);
   return V->getContext().pImpl->ValuesAsMetadata.lookup(V);
 }
 
 void ValueAsMetadata::handleDeletion(Value *V) {
   assert(V && "Expected valid value");
+  UniquingLock Guard(V->getContext().pImpl,
+                     V->getContext().pImpl->MetadataLock);
 
   auto &Store = V->getType()->getContext().pImpl->ValuesAsMetadata;
   auto I = Store.find(V);
@@ -293,6 +303,8 @@ void ValueAsMetadata::handleDeletion(Value *V) {
 }
 
 void ValueAsMetadata::handleRAUW(Value *From, Value *To) {
+  UniquingLock Guard(From->getContext().pImpl,
+                     From->getContext().pImpl->MetadataLock);
   assert(From && "Expected valid value");
   assert(To && "Expected valid value");
   assert(From != To && "Expected changed value");
@@ -358,6 +370,7 @@ void ValueAsMetadata::handleRAUW(Value *From, Value *To) {
 //
 
 MDString *MDString::get(LLVMContext &Context, StringRef Str) {
+  UniquingLock Guard(Context.pImpl, Context.pImpl->MetadataLock);
   auto &Store = Context.pImpl->MDStringCache;
   auto I = Store.find(Str);
   if (I != Store.end())
@@ -565,6 +578,7 @@ void MDNode::dropAllReferences() {
 }
 
 void MDNode::handleChangedOperand(void *Ref, Metadata *New) {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   unsigned Op = static_cast<MDOperand *>(Ref) - op_begin();
   assert(Op < getNumOperands() && "Expected valid operand");
 
@@ -647,6 +661,7 @@ template <class NodeTy> struct MDNode::HasCachedHash {
 };
 
 MDNode *MDNode::uniquify() {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   assert(!hasSelfReference(this) && "Cannot uniquify a self-referencing node");
 
   // Try to insert into uniquing store.
@@ -666,6 +681,7 @@ MDNode *MDNode::uniquify() {
 }
 
 void MDNode::eraseFromStore() {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   switch (getMetadataID()) {
   default:
     llvm_unreachable("Invalid subclass of MDNode");
@@ -679,6 +695,7 @@ void MDNode::eraseFromStore() {
 
 MDTuple *MDTuple::getImpl(LLVMContext &Context, ArrayRef<Metadata *> MDs,
                           StorageType Storage, bool ShouldCreate) {
+  UniquingLock Guard(Context.pImpl, Context.pImpl->MetadataLock);
   unsigned Hash = 0;
   if (Storage == Uniqued) {
     MDTupleInfo::KeyTy Key(MDs);
@@ -702,6 +719,7 @@ void MDNode::deleteTemporary(MDNode *N) {
 }
 
 void MDNode::storeDistinctInContext() {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   assert(isResolved() && "Expected resolved nodes");
   Storage = Distinct;
 
@@ -983,6 +1001,7 @@ MDNode *Instruction::getMetadataImpl(StringRef Kind) const {
 }
 
 void Instruction::dropUnknownMetadata(ArrayRef<unsigned> KnownIDs) {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   SmallSet<unsigned, 5> KnownSet;
   KnownSet.insert(KnownIDs.begin(), KnownIDs.end());
 
@@ -1030,6 +1049,7 @@ void Instruction::dropUnknownMetadata(ArrayRef<unsigned> KnownIDs) {
 /// node.  This updates/replaces metadata if already present, or removes it if
 /// Node is null.
 void Instruction::setMetadata(unsigned KindID, MDNode *Node) {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   if (!Node && !hasMetadata())
     return;
 
@@ -1094,6 +1114,7 @@ void Instruction::setAAMetadata(const AAMDNodes &N) {
 }
 
 MDNode *Instruction::getMetadataImpl(unsigned KindID) const {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   // Handle 'dbg' as a special case since it is not stored in the hash table.
   if (KindID == LLVMContext::MD_dbg)
     return DbgLoc.getAsMDNode();
@@ -1111,6 +1132,7 @@ MDNode *Instruction::getMetadataImpl(unsigned KindID) const {
 
 void Instruction::getAllMetadataImpl(
     SmallVectorImpl<std::pair<unsigned, MDNode *>> &Result) const {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   Result.clear();
   
   // Handle 'dbg' as a special case since it is not stored in the hash table.
@@ -1138,6 +1160,7 @@ void Instruction::getAllMetadataImpl(
 
 void Instruction::getAllMetadataOtherThanDebugLocImpl(
     SmallVectorImpl<std::pair<unsigned, MDNode *>> &Result) const {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   Result.clear();
   assert(hasMetadataHashEntry() &&
          getContext().pImpl->MetadataStore.count(this) &&
@@ -1157,6 +1180,7 @@ void Instruction::getAllMetadataOtherThanDebugLocImpl(
 /// clearMetadataHashEntries - Clear all hashtable-based metadata from
 /// this instruction.
 void Instruction::clearMetadataHashEntries() {
+  UniquingLock Guard(getContext().pImpl, getContext().pImpl->MetadataLock);
   assert(hasMetadataHashEntry() && "Caller should check");
   getContext().pImpl->MetadataStore.erase(this);
   setHasMetadataHashEntry(false);
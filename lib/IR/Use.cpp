@@ -8,16 +8,77 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/Use.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Type.h"
 #include "llvm/IR/User.h"
 #include "llvm/IR/Value.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
 #include <new>
 
 namespace llvm {
 
+std::atomic<unsigned> Use::NumConcurrentContexts(0);
+
+namespace {
+/// Locks guarding the use lists of values in contexts with concurrent uniquing,
+/// striped by the address of the used value.
+struct UseListLockTable {
+  enum { NumLocks = 64 };
+  sys::SmartMutex<false> Locks[NumLocks];
+
+  sys::SmartMutex<false> &get(const Value *V) {
+    return Locks[(reinterpret_cast<uintptr_t>(V) >> 4) % NumLocks];
+  }
+};
+}
+
+static ManagedStatic<UseListLockTable> UseListLocks;
+
+/// Whether the use list of V may be updated from several threads at once. In a
+/// context with concurrent uniquing, constants and globals may be used by
+/// functions that are being transformed on other threads.
+static bool hasConcurrentUseList(const Value *V) {
+  return V->getType()->getContext().hasConcurrentUniquing();
+}
+
+void Use::setMaybeConcurrently(Value *V) {
+  if (Value *Used = V ? V : Val)
+    if (hasConcurrentUseList(Used))
+      return setConcurrently(V);
+  if (Val)
+    removeFromList();
+  Val = V;
+  if (V)
+    V->addUse(*this);
+}
+
+void Use::setConcurrently(Value *V) {
+  if (Val) {
+    sys::SmartScopedLock<false> Lock(UseListLocks->get(Val));
+    removeFromList();
+  }
+  Val = V;
+  if (V) {
+    sys::SmartScopedLock<false> Lock(UseListLocks->get(V));
+    V->addUse(*this);
+  }
+}
+
 void Use::swap(Use &RHS) {
   if (Val == RHS.Val)
     return;
 
+  if (LLVM_UNLIKELY(NumConcurrentContexts.load(std::memory_order_relaxed)) &&
+      hasConcurrentUseList(Val ? Val : RHS.Val)) {
+    // Move each use separately so that only one use list is locked at a time;
+    // the resulting list order is the same as below.
+    Value *OldVal = Val;
+    setConcurrently(RHS.Val);
+    RHS.setConcurrently(OldVal);
+    return;
+  }
+
   if (Val)
     removeFromList();
 
@@ -188,8 +188,11 @@ void Value::setName(const Twine &NewName) {
   if (getSymTab(this, ST))
     return;  // Cannot set a name on this value (e.g. constant).
 
-  if (Function *F = dyn_cast<Function>(this))
-    getContext().pImpl->IntrinsicIDCache.erase(F);
+  if (Function *F = dyn_cast<Function>(this)) {
+    LLVMContextImpl *pImpl = getContext().pImpl;
+    UniquingLock Lock(pImpl, pImpl->ModuleLock);
+    pImpl->IntrinsicIDCache.erase(F);
+  }
 
   if (!ST) { // No symbol table to update?  Just do the change.
     if (NameRef.empty()) {
@@ -647,6 +650,8 @@ void Value::reverseUseList() {
 
 void ValueHandleBase::AddToExistingUseList(ValueHandleBase **List) {
   assert(List && "Handle list is null?");
+  UniquingLock Lock(V->getContext().pImpl,
+                    V->getContext().pImpl->ValueHandlesLock);
 
   // Splice ourselves into the list.
   Next = *List;
@@ -660,6 +665,8 @@ void ValueHandleBase::AddToExistingUseList(ValueHandleBase **List) {
 
 void ValueHandleBase::AddToExistingUseListAfter(ValueHandleBase *List) {
   assert(List && "Must insert after existing node");
+  UniquingLock Lock(V->getContext().pImpl,
+                    V->getContext().pImpl->ValueHandlesLock);
 
   Next = List->Next;
   setPrevPtr(&List->Next);
@@ -672,6 +679,7 @@ void ValueHandleBase::AddToUseList() {
   assert(V && "Null pointer doesn't have a use list!");
 
   LLVMContextImpl *pImpl = V->getContext().pImpl;
+  UniquingLock Lock(pImpl, pImpl->ValueHandlesLock);
 
   if (V->HasValueHandle) {
     // If this value already has a ValueHandle, then it must be in the
@@ -714,6 +722,8 @@ void ValueHandleBase::AddToUseList() {
 void ValueHandleBase::RemoveFromUseList() {
   assert(V && V->HasValueHandle &&
          "Pointer doesn't have a use list!");
+  LLVMContextImpl *pImpl = V->getContext().pImpl;
+  UniquingLock Lock(pImpl, pImpl->ValueHandlesLock);
 
   // Unlink this from its use list.
   ValueHandleBase **PrevPtr = getPrevPtr();
@@ -729,7 +739,6 @@ void ValueHandleBase::RemoveFromUseList() {
   // If the Next pointer was null, then it is possible that this was the last
   // ValueHandle watching VP.  If so, delete its entry from the ValueHandles
   // map.
-  LLVMContextImpl *pImpl = V->getContext().pImpl;
   DenseMap<Value*, ValueHandleBase*> &Handles = pImpl->ValueHandles;
   if (Handles.isPointerIntoBucketsArray(PrevPtr)) {
     Handles.erase(V);
@@ -744,6 +753,7 @@ void ValueHandleBase::ValueIsDeleted(Value *V) {
   // Get the linked list base, which is guaranteed to exist since the
   // HasValueHandle flag is set.
   LLVMContextImpl *pImpl = V->getContext().pImpl;
+  UniquingLock Lock(pImpl, pImpl->ValueHandlesLock);
   ValueHandleBase *Entry = pImpl->ValueHandles[V];
   assert(Entry && "Value bit set but no entries exist");
 
@@ -804,6 +814,7 @@ void ValueHandleBase::ValueIsRAUWd(Value *Old, Value *New) {
   // Get the linked list base, which is guaranteed to exist since the
   // HasValueHandle flag is set.
   LLVMContextImpl *pImpl = Old->getContext().pImpl;
+  UniquingLock Lock(pImpl, pImpl->ValueHandlesLock);
   ValueHandleBase *Entry = pImpl->ValueHandles[Old];
 
   assert(Entry && "Value bit set but no entries exist");
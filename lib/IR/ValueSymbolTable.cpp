@@ -40,6 +40,8 @@ void ValueSymbolTable::reinsertValue(Value* V) {
   // Try inserting the name, assuming it won't conflict.
   if (vmap.insert(V->getValueName())) {
     //DEBUG(dbgs() << " Inserted value: " << V->getValueName() << ": " << *V << "\n");
+    if (UniquedNames)
+      UniquedNames->erase(V);
     return;
   }
   
@@ -60,6 +62,8 @@ void ValueSymbolTable::reinsertValue(Value* V) {
     if (IterBool.second) {
       // Newly inserted name.  Success!
       V->setValueName(&*IterBool.first);
+      if (UniquedNames)
+        (*UniquedNames)[V] = BaseSize;
      //DEBUG(dbgs() << " Inserted value: " << UniqueName << ": " << *V << "\n");
       return;
     }
@@ -81,6 +85,8 @@ ValueName *ValueSymbolTable::createValueName(StringRef Name, Value *V) {
   if (IterBool.second) {
     //DEBUG(dbgs() << " Inserted value: " << Entry.getKeyData() << ": "
     //           << *V << "\n");
+    if (UniquedNames)
+      UniquedNames->erase(V);
     return &*IterBool.first;
   }
   
@@ -97,6 +103,8 @@ ValueName *ValueSymbolTable::createValueName(StringRef Name, Value *V) {
     if (IterBool.second) {
       // DEBUG(dbgs() << " Inserted value: " << UniqueName << ": " << *V <<
       //       "\n");
+      if (UniquedNames)
+        (*UniquedNames)[V] = Name.size();
       return &*IterBool.first;
     }
   }
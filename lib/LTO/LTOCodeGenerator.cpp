@@ -18,6 +18,7 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/CodeGen/RuntimeLibcalls.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
@@ -587,6 +588,42 @@ bool LTOCodeGenerator::compileOptimized(raw_ostream &out, std::string &errMsg) {
   return true;
 }
 
+bool LTOCodeGenerator::compileOptimized(ArrayRef<raw_ostream *> out,
+                                        std::string &errMsg) {
+  assert(!out.empty() && "No output streams given");
+  if (out.size() == 1)
+    return compileOptimized(*out[0], errMsg);
+
+  if (!this->determineTarget(errMsg))
+    return false;
+
+  Module *mergedModule = IRLinker.getModule();
+
+  // Mark which symbols can not be internalized
+  this->applyScopeRestrictions();
+
+  // The partitions are code generated in contexts of their own, so run the
+  // IR passes that would otherwise be scheduled ahead of code generation on
+  // the merged module before splitting it.
+  legacy::PassManager preCodeGenPasses;
+  mergedModule->setDataLayout(TargetMach->getDataLayout());
+  preCodeGenPasses.add(new DataLayoutPass());
+
+  // If the bitcode files contain ARC code and were compiled with optimization,
+  // the ObjCARCContractPass must be run, so do it unconditionally here.
+  preCodeGenPasses.add(createObjCARCContractPass());
+  preCodeGenPasses.run(*mergedModule);
+
+  // The partitions look their target up from the module triple.
+  if (mergedModule->getTargetTriple().empty())
+    mergedModule->setTargetTriple(TargetMach->getTargetTriple());
+
+  return splitCodeGen(*mergedModule, out, TargetMach->getTargetCPU(),
+                      TargetMach->getTargetFeatureString(), Options, errMsg,
+                      TargetMach->getRelocationModel(),
+                      TargetMach->getCodeModel(), TargetMach->getOptLevel());
+}
+
 /// setCodeGenDebugOptions - Set codegen debugging options to aid in debugging
 /// LTO problems.
 void LTOCodeGenerator::setCodeGenDebugOptions(const char *options) {
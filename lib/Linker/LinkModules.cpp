@@ -34,6 +34,15 @@
 #include <tuple>
 using namespace llvm;
 
+#define DEBUG_TYPE "linker"
+
+STATISTIC(NumBodiesLinked, "Number of function bodies linked");
+STATISTIC(NumBodiesNotLinked, "Number of function bodies not linked");
+STATISTIC(NumBodiesNotMaterialized,
+          "Number of function bodies not linked and never materialized");
+STATISTIC(NumInstsNotLinked,
+          "Number of instructions in materialized bodies not linked");
+
 
 //===----------------------------------------------------------------------===//
 // TypeMap implementation.
@@ -65,8 +74,14 @@ public:
 
   Linker::IdentifiedStructTypeSet &DstStructTypesSet;
   /// Indicate that the specified type in the destination module is conceptually
-  /// equivalent to the specified type in the source module.
-  void addTypeMapping(Type *DstTy, Type *SrcTy);
+  /// equivalent to the specified type in the source module. Returns false if
+  /// the types turned out not to be isomorphic.
+  bool addTypeMapping(Type *DstTy, Type *SrcTy);
+
+  /// Return true if \p SrcTy already has a destination type.
+  bool hasMapping(Type *SrcTy) const {
+    return MappedTypes.lookup(SrcTy) != nullptr;
+  }
 
   /// Produce a body for an opaque type in the dest module from a type
   /// definition in the source module.
@@ -101,13 +116,14 @@ private:
 };
 }
 
-void TypeMapTy::addTypeMapping(Type *DstTy, Type *SrcTy) {
+bool TypeMapTy::addTypeMapping(Type *DstTy, Type *SrcTy) {
   assert(SpeculativeTypes.empty());
   assert(SpeculativeDstOpaqueTypes.empty());
 
   // Check to see if these types are recursively isomorphic and establish a
   // mapping between them if so.
-  if (!areTypesIsomorphic(DstTy, SrcTy)) {
+  bool Isomorphic = areTypesIsomorphic(DstTy, SrcTy);
+  if (!Isomorphic) {
     // Oops, they aren't isomorphic.  Just discard this request by rolling out
     // any speculative mappings we've established.
     for (Type *Ty : SpeculativeTypes)
@@ -125,6 +141,7 @@ void TypeMapTy::addTypeMapping(Type *DstTy, Type *SrcTy) {
   }
   SpeculativeTypes.clear();
   SpeculativeDstOpaqueTypes.clear();
+  return Isomorphic;
 }
 
 /// Recursively walk this pair of types, returning true if they are isomorphic,
@@ -423,16 +440,23 @@ class ModuleLinker {
 
   DiagnosticHandlerFunction DiagnosticHandler;
 
+  /// Linker::Flags for this link.
+  unsigned Flags;
+
 public:
   ModuleLinker(Module *dstM, Linker::IdentifiedStructTypeSet &Set, Module *srcM,
-               DiagnosticHandlerFunction DiagnosticHandler)
+               DiagnosticHandlerFunction DiagnosticHandler, unsigned Flags)
       : DstM(dstM), SrcM(srcM), TypeMap(Set),
         ValMaterializer(TypeMap, DstM, LazilyLinkGlobalValues),
-        DiagnosticHandler(DiagnosticHandler) {}
+        DiagnosticHandler(DiagnosticHandler), Flags(Flags) {}
 
   bool run();
 
 private:
+  bool shouldLinkOnlyNeeded() const {
+    return Flags & Linker::Flags::LinkOnlyNeeded;
+  }
+
   bool shouldLinkFromSource(bool &LinkFromSrc, const GlobalValue &Dest,
                             const GlobalValue &Src);
 
@@ -877,6 +901,20 @@ void ModuleLinker::computeTypeMapping() {
       TypeMap.addTypeMapping(DST, ST);
   }
 
+  // The above only tries the one destination type with the prefix name. When
+  // several modules disagree on a type, the destination has several types
+  // with that name stem, and a recursive type matching one of the others
+  // would get yet another copy, since TypeMapTy::get can't unify recursive
+  // types. Look up the candidates by their name stem and shape instead, and
+  // only check those for isomorphism.
+  for (StructType *ST : Types) {
+    if (!ST->hasName() || ST->isOpaque() || TypeMap.hasMapping(ST))
+      continue;
+    for (StructType *DST : TypeMap.DstStructTypesSet.findNonOpaqueByShape(ST))
+      if (TypeMap.addTypeMapping(DST, ST))
+        break;
+  }
+
   // Now that we have discovered all of the type equivalences, get a body for
   // any 'opaque' types in the dest module that are now resolved.
   TypeMap.linkDefinedTypeBodies();
@@ -1077,8 +1115,13 @@ bool ModuleLinker::linkGlobalValueProto(GlobalValue *SGV) {
   } else {
     // If the GV is to be lazily linked, don't create it just yet.
     // The ValueMaterializerTy will deal with creating it if it's used.
+    // When only linking what is needed, this also covers every definition
+    // the destination doesn't already have, except for appending variables
+    // such as llvm.global_ctors, which are roots of their own.
     if (!DGV && (SGV->hasLocalLinkage() || SGV->hasLinkOnceLinkage() ||
-                 SGV->hasAvailableExternallyLinkage())) {
+                 SGV->hasAvailableExternallyLinkage() ||
+                 (shouldLinkOnlyNeeded() && !SGV->isDeclaration() &&
+                  !SGV->hasAppendingLinkage()))) {
       DoNotLinkFromSource.insert(SGV);
       return false;
     }
@@ -1201,6 +1244,7 @@ bool ModuleLinker::linkFunctionBody(Function &Dst, Function &Src) {
 
   // Splice the body of the source function into the dest function.
   Dst.getBasicBlockList().splice(Dst.end(), Src.getBasicBlockList());
+  ++NumBodiesLinked;
 
   // At this point, all of the instructions and values of the function are now
   // copied over.  The only problem is that they are still referencing values in
@@ -1592,6 +1636,11 @@ bool ModuleLinker::run() {
     linkGlobalValueBody(Src);
   }
 
+  // The source module may have been loaded with lazy metadata, in which case
+  // the named metadata is only available once it has been materialized.
+  if (std::error_code EC = SrcM->materializeMetadata())
+    return emitError(EC.message());
+
   // Strip replaced subprograms before linking together compile units.
   stripReplacedSubprograms();
 
@@ -1623,6 +1672,21 @@ bool ModuleLinker::run() {
       return true;
   }
 
+  // Whatever still has a body in the source was not needed. Bodies that were
+  // never materialized were never read from the bitcode either.
+  if (AreStatisticsEnabled())
+    for (Function &SF : *SrcM) {
+      if (SF.isDeclaration())
+        continue;
+      ++NumBodiesNotLinked;
+      if (SF.isMaterializable()) {
+        ++NumBodiesNotMaterialized;
+        continue;
+      }
+      for (BasicBlock &BB : SF)
+        NumInstsNotLinked += BB.size();
+    }
+
   return false;
 }
 
@@ -1679,9 +1743,56 @@ bool Linker::StructTypeKeyInfo::isEqual(const StructType *LHS,
   return KeyTy(LHS) == KeyTy(RHS);
 }
 
+/// Strip the ".<number>" suffixes that LLVMContext adds to keep struct names
+/// unique, giving the name the type most likely had in its own module.
+static StringRef getStructNameStem(StringRef Name) {
+  for (;;) {
+    size_t DotPos = Name.rfind('.');
+    if (DotPos == 0 || DotPos == StringRef::npos || DotPos + 1 == Name.size())
+      return Name;
+    if (Name.find_first_not_of("0123456789", DotPos + 1) != StringRef::npos)
+      return Name;
+    Name = Name.substr(0, DotPos);
+  }
+}
+
+/// Hash the shape of \p Ty such that isomorphic types hash the same.
+/// Identified structs nested in \p Ty only contribute the fact that they are
+/// one. That way the hash neither depends on how a recursive type is unrolled
+/// nor changes when a nested opaque type gets a body.
+static hash_code hashTypeShape(Type *Ty, bool IsTopLevel) {
+  auto *STy = dyn_cast<StructType>(Ty);
+  if (STy && !STy->isLiteral() && !IsTopLevel)
+    return hash_value(Type::StructTyID);
+
+  hash_code Hash = hash_combine(Ty->getTypeID(), Ty->getNumContainedTypes());
+  if (auto *ITy = dyn_cast<IntegerType>(Ty))
+    Hash = hash_combine(Hash, ITy->getBitWidth());
+  else if (auto *PTy = dyn_cast<PointerType>(Ty))
+    Hash = hash_combine(Hash, PTy->getAddressSpace());
+  else if (auto *FTy = dyn_cast<FunctionType>(Ty))
+    Hash = hash_combine(Hash, FTy->isVarArg());
+  else if (STy)
+    Hash = hash_combine(Hash, STy->isPacked());
+  else if (auto *ATy = dyn_cast<ArrayType>(Ty))
+    Hash = hash_combine(Hash, ATy->getNumElements());
+  else if (auto *VTy = dyn_cast<VectorType>(Ty))
+    Hash = hash_combine(Hash, VTy->getNumElements());
+
+  for (Type *ElTy : Ty->subtypes())
+    Hash = hash_combine(Hash, hashTypeShape(ElTy, /*IsTopLevel=*/false));
+  return Hash;
+}
+
+static hash_code hashStructTypeNameAndShape(StructType *Ty) {
+  return hash_combine(getStructNameStem(Ty->getName()),
+                      hashTypeShape(Ty, /*IsTopLevel=*/true));
+}
+
 void Linker::IdentifiedStructTypeSet::addNonOpaque(StructType *Ty) {
   assert(!Ty->isOpaque());
-  NonOpaqueStructTypes.insert(Ty);
+  if (NonOpaqueStructTypes.insert(Ty).second && Ty->hasName())
+    NonOpaqueStructTypesByShape[hashStructTypeNameAndShape(Ty)].push_back(Ty);
 }
 
 void Linker::IdentifiedStructTypeSet::addOpaque(StructType *Ty) {
@@ -1699,6 +1810,14 @@ Linker::IdentifiedStructTypeSet::findNonOpaque(ArrayRef<Type *> ETypes,
   return *I;
 }
 
+ArrayRef<StructType *>
+Linker::IdentifiedStructTypeSet::findNonOpaqueByShape(StructType *Ty) {
+  auto I = NonOpaqueStructTypesByShape.find(hashStructTypeNameAndShape(Ty));
+  if (I == NonOpaqueStructTypesByShape.end())
+    return ArrayRef<StructType *>();
+  return I->second;
+}
+
 bool Linker::IdentifiedStructTypeSet::hasType(StructType *Ty) {
   if (Ty->isOpaque())
     return OpaqueStructTypes.count(Ty);
@@ -1740,9 +1859,9 @@ void Linker::deleteModule() {
   Composite = nullptr;
 }
 
-bool Linker::linkInModule(Module *Src) {
+bool Linker::linkInModule(Module *Src, unsigned Flags) {
   ModuleLinker TheLinker(Composite, IdentifiedStructTypes, Src,
-                         DiagnosticHandler);
+                         DiagnosticHandler, Flags);
   bool RetCode = TheLinker.run();
   Composite->dropTriviallyDeadConstantArrays();
   return RetCode;
@@ -1762,14 +1881,15 @@ void Linker::setModule(Module *Dst) {
 /// Upon failure, the Dest module could be in a modified state, and shouldn't be
 /// relied on to be consistent.
 bool Linker::LinkModules(Module *Dest, Module *Src,
-                         DiagnosticHandlerFunction DiagnosticHandler) {
+                         DiagnosticHandlerFunction DiagnosticHandler,
+                         unsigned Flags) {
   Linker L(Dest, DiagnosticHandler);
-  return L.linkInModule(Src);
+  return L.linkInModule(Src, Flags);
 }
 
-bool Linker::LinkModules(Module *Dest, Module *Src) {
+bool Linker::LinkModules(Module *Dest, Module *Src, unsigned Flags) {
   Linker L(Dest);
-  return L.linkInModule(Src);
+  return L.linkInModule(Src, Flags);
 }
 
 //===----------------------------------------------------------------------===//
@@ -33,13 +33,23 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/ThreadPool.h"
+#include <cstring>
+#include <memory>
 #include <vector>
 using namespace llvm;
 
 #undef  DEBUG_TYPE
 #define DEBUG_TYPE "reloc-info"
 
+/// The threads that -parallel-object-writing uses, created the first time an
+/// object is written that way and shared by all the objects of the process.
+/// Every writer waits for its own tasks through a ThreadPoolTaskGroup.
+static ManagedStatic<ThreadPool> ObjectWritingPool;
+
 namespace {
 class FragmentWriter {
   bool IsLittleEndian;
@@ -79,6 +89,28 @@ public:
                    uint8_t other, uint32_t shndx, bool Reserved);
 };
 
+/// Writes the contents of a single section to its own stream, so that the
+/// sections of an object can be written concurrently.
+class SectionDataWriter : public MCObjectWriter {
+public:
+  SectionDataWriter(raw_ostream &OS, bool IsLittleEndian)
+      : MCObjectWriter(OS, IsLittleEndian) {}
+
+  void ExecutePostLayoutBinding(MCAssembler &Asm,
+                                const MCAsmLayout &Layout) override {
+    llvm_unreachable("Only used to write section data");
+  }
+  void RecordRelocation(MCAssembler &Asm, const MCAsmLayout &Layout,
+                        const MCFragment *Fragment, const MCFixup &Fixup,
+                        MCValue Target, bool &IsPCRel,
+                        uint64_t &FixedValue) override {
+    llvm_unreachable("Only used to write section data");
+  }
+  void WriteObject(MCAssembler &Asm, const MCAsmLayout &Layout) override {
+    llvm_unreachable("Only used to write section data");
+  }
+};
+
 struct ELFRelocationEntry {
   uint64_t Offset; // Where is the relocation.
   const MCSymbol *Symbol;       // The symbol to relocate with.
@@ -150,6 +182,9 @@ class ELFObjectWriter : public MCObjectWriter {
     Relocations;
     StringTableBuilder ShStrTabBuilder;
 
+    /// The debug sections that were compressed into SHF_COMPRESSED sections.
+    SmallPtrSet<const MCSectionELF *, 16> CompressedSections;
+
     /// @}
     /// @name Symbol Table Data
     /// @{
@@ -254,10 +289,13 @@ class ELFObjectWriter : public MCObjectWriter {
     MCSectionData *createRelocationSection(MCAssembler &Asm,
                                            const MCSectionData &SD);
 
-    void CompressDebugSections(MCAssembler &Asm, MCAsmLayout &Layout);
+    /// Compress the debug sections if requested, on \p Pool if one is given.
+    void CompressDebugSections(MCAssembler &Asm, MCAsmLayout &Layout,
+                               ThreadPool *Pool);
 
+    /// Fill in the relocation sections, on \p Pool if one is given.
     void WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
-                          const RelMapTy &RelMap);
+                          const RelMapTy &RelMap, ThreadPool *Pool);
 
     void CreateMetadataSections(MCAssembler &Asm, MCAsmLayout &Layout,
                                 SectionIndexMapTy &SectionIndexMap);
@@ -279,6 +317,15 @@ class ELFObjectWriter : public MCObjectWriter {
                             const RelMapTy &RelMap,
                             const SectionOffsetMapTy &SectionOffsetMap);
 
+    /// Write the data of \p Sections, which start at the current position
+    /// in the output and end at file offset \p End. All the sections are
+    /// written into one buffer on \p Pool, at the offsets computed for them.
+    void writeSectionDataInParallel(MCAssembler &Asm,
+                                    const MCAsmLayout &Layout,
+                                    ArrayRef<const MCSectionELF *> Sections,
+                                    const SectionOffsetMapTy &SectionOffsetMap,
+                                    uint64_t End, ThreadPool &Pool);
+
     void ComputeSectionOrder(MCAssembler &Asm,
                              std::vector<const MCSectionELF*> &Sections);
 
@@ -289,7 +336,7 @@ class ELFObjectWriter : public MCObjectWriter {
 
     void WriteRelocationsFragment(const MCAssembler &Asm,
                                   MCDataFragment *F,
-                                  const MCSectionData *SD);
+                                  std::vector<ELFRelocationEntry> &Relocs);
 
     bool
     IsSymbolRefDifferenceFullyResolvedImpl(const MCAssembler &Asm,
@@ -1091,7 +1138,10 @@ ELFObjectWriter::computeSymbolTable(MCAssembler &Asm, const MCAsmLayout &Layout,
   for (auto i = Asm.file_names_begin(), e = Asm.file_names_end(); i != e; ++i)
     StrTabBuilder.add(*i);
 
-  StrTabBuilder.finalize(StringTableBuilder::ELF);
+  if (Asm.getContext().getAsmInfo()->fastStringTables())
+    StrTabBuilder.finalizeInOrder(StringTableBuilder::ELF);
+  else
+    StrTabBuilder.finalize(StringTableBuilder::ELF);
 
   for (auto i = Asm.file_names_begin(), e = Asm.file_names_end(); i != e; ++i)
     FileSymbolData.push_back(StrTabBuilder.getOffset(*i));
@@ -1155,10 +1205,13 @@ ELFObjectWriter::createRelocationSection(MCAssembler &Asm,
   return &Asm.getOrCreateSectionData(*RelaSection);
 }
 
-static SmallVector<char, 128>
-getUncompressedData(MCAsmLayout &Layout,
-                    MCSectionData::FragmentListType &Fragments) {
-  SmallVector<char, 128> UncompressedData;
+// Return the contents of the fragments of a debug section, so that they can be
+// compressed without first being copied into a single buffer.
+static std::vector<StringRef>
+getUncompressedData(const MCSectionData::FragmentListType &Fragments,
+                    uint64_t &Size) {
+  std::vector<StringRef> Pieces;
+  Size = 0;
   for (const MCFragment &F : Fragments) {
     const SmallVectorImpl<char> *Contents;
     switch (F.getKind()) {
@@ -1175,52 +1228,70 @@ getUncompressedData(MCAsmLayout &Layout,
       llvm_unreachable(
           "Not expecting any other fragment types in a debug_* section");
     }
-    UncompressedData.append(Contents->begin(), Contents->end());
+    Pieces.push_back(StringRef(Contents->data(), Contents->size()));
+    Size += Contents->size();
   }
-  return UncompressedData;
+  return Pieces;
 }
 
-// Include the debug info compression header:
-// "ZLIB" followed by 8 bytes representing the uncompressed size of the section,
-// useful for consumers to preallocate a buffer to decompress into.
-static bool
-prependCompressionHeader(uint64_t Size,
-                         SmallVectorImpl<char> &CompressedContents) {
-  static const StringRef Magic = "ZLIB";
-  if (Size <= Magic.size() + sizeof(Size) + CompressedContents.size())
-    return false;
-  if (sys::IsLittleEndianHost)
-    sys::swapByteOrder(Size);
-  CompressedContents.insert(CompressedContents.begin(),
-                            Magic.size() + sizeof(Size), 0);
-  std::copy(Magic.begin(), Magic.end(), CompressedContents.begin());
-  std::copy(reinterpret_cast<char *>(&Size),
-            reinterpret_cast<char *>(&Size + 1),
-            CompressedContents.begin() + Magic.size());
-  return true;
+template <support::endianness E>
+static void writeCompressionHeader(raw_ostream &OS, bool Is64Bit,
+                                   uint64_t Size, uint64_t Alignment) {
+  support::endian::Writer<E> W(OS);
+  W.template write<uint32_t>(ELF::ELFCOMPRESS_ZLIB);
+  if (Is64Bit) {
+    W.template write<uint32_t>(0); // ch_reserved
+    W.template write<uint64_t>(Size);
+    W.template write<uint64_t>(Alignment);
+  } else {
+    W.template write<uint32_t>(Size);
+    W.template write<uint32_t>(Alignment);
+  }
 }
 
-// Return a single fragment containing the compressed contents of the whole
-// section. Null if the section was not compressed for any reason.
+// Write the header that precedes the compressed contents of a section. The
+// GNU format uses "ZLIB" followed by the uncompressed size as a big-endian
+// 64 bit number, SHF_COMPRESSED sections start with an Elf32/64_Chdr. Either
+// way consumers can preallocate a buffer to decompress into.
+static void writeCompressionHeader(DebugCompression::Type Type, bool Is64Bit,
+                                   bool IsLittleEndian, uint64_t Size,
+                                   uint64_t Alignment,
+                                   SmallVectorImpl<char> &Contents) {
+  raw_svector_ostream OS(Contents);
+  if (Type == DebugCompression::ZlibGnu) {
+    OS << "ZLIB";
+    support::endian::Writer<support::big>(OS).write(Size);
+  } else if (IsLittleEndian) {
+    writeCompressionHeader<support::little>(OS, Is64Bit, Size, Alignment);
+  } else {
+    writeCompressionHeader<support::big>(OS, Is64Bit, Size, Alignment);
+  }
+  OS.flush();
+}
+
+// Return a single fragment containing the compression header and the
+// compressed contents of the whole section. Null if the section was not
+// compressed for any reason.
 static std::unique_ptr<MCDataFragment>
-getCompressedFragment(MCAsmLayout &Layout,
-                      MCSectionData::FragmentListType &Fragments) {
+getCompressedFragment(DebugCompression::Type Type, bool Is64Bit,
+                      bool IsLittleEndian, const MCSectionData &SD) {
   std::unique_ptr<MCDataFragment> CompressedFragment(new MCDataFragment());
-
-  // Gather the uncompressed data from all the fragments, recording the
-  // alignment fragment, if seen, and any fixups.
-  SmallVector<char, 128> UncompressedData =
-      getUncompressedData(Layout, Fragments);
-
   SmallVectorImpl<char> &CompressedContents = CompressedFragment->getContents();
 
-  zlib::Status Success = zlib::compress(
-      StringRef(UncompressedData.data(), UncompressedData.size()),
-      CompressedContents);
+  uint64_t Size;
+  std::vector<StringRef> UncompressedData =
+      getUncompressedData(SD.getFragmentList(), Size);
+  writeCompressionHeader(Type, Is64Bit, IsLittleEndian, Size,
+                         SD.getAlignment(), CompressedContents);
+
+  // The fragments are streamed through the compressor, which appends to the
+  // header.
+  zlib::Status Success = zlib::compress(UncompressedData, CompressedContents);
   if (Success != zlib::StatusOK)
     return nullptr;
 
-  if (!prependCompressionHeader(UncompressedData.size(), CompressedContents))
+  // Only keep the compressed contents if they actually save space.
+  if (Size <= CompressedContents.size())
     return nullptr;
 
   return CompressedFragment;
@@ -1239,20 +1310,13 @@ static void UpdateSymbols(const MCAsmLayout &Layout,
   }
 }
 
-static void CompressDebugSection(MCAssembler &Asm, MCAsmLayout &Layout,
-                                 const DefiningSymbolMap &DefiningSymbols,
-                                 const MCSectionELF &Section,
-                                 MCSectionData &SD) {
-  StringRef SectionName = Section.getSectionName();
+// Replace the fragments of a debug section with its compressed contents.
+static void ReplaceWithCompressedFragment(
+    MCAssembler &Asm, MCAsmLayout &Layout,
+    const DefiningSymbolMap &DefiningSymbols, MCSectionData &SD,
+    std::unique_ptr<MCDataFragment> CompressedFragment) {
   MCSectionData::FragmentListType &Fragments = SD.getFragmentList();
 
-  std::unique_ptr<MCDataFragment> CompressedFragment =
-      getCompressedFragment(Layout, Fragments);
-
-  // Leave the section as-is if the fragments could not be compressed.
-  if (!CompressedFragment)
-    return;
-
   // Update the fragment+offsets of any symbols referring to fragments in this
   // section to refer to the new fragment.
   auto I = DefiningSymbols.find(&SD);
@@ -1268,23 +1332,17 @@ static void CompressDebugSection(MCAssembler &Asm, MCAsmLayout &Layout,
   CompressedFragment->setParent(&SD);
   CompressedFragment->setLayoutOrder(0);
   Fragments.push_back(CompressedFragment.release());
-
-  // Rename from .debug_* to .zdebug_*
-  Asm.getContext().renameELFSection(&Section,
-                                    (".z" + SectionName.drop_front(1)).str());
 }
 
 void ELFObjectWriter::CompressDebugSections(MCAssembler &Asm,
-                                            MCAsmLayout &Layout) {
-  if (!Asm.getContext().getAsmInfo()->compressDebugSections())
+                                            MCAsmLayout &Layout,
+                                            ThreadPool *Pool) {
+  DebugCompression::Type Type =
+      Asm.getContext().getAsmInfo()->compressDebugSections();
+  if (Type == DebugCompression::None)
     return;
 
-  DefiningSymbolMap DefiningSymbols;
-
-  for (MCSymbolData &SD : Asm.symbols())
-    if (MCFragment *F = SD.getFragment())
-      DefiningSymbols[F->getParent()].push_back(&SD);
-
+  std::vector<MCSectionData *> DebugSections;
   for (MCSectionData &SD : Asm) {
     const MCSectionELF &Section =
         static_cast<const MCSectionELF &>(SD.getSection());
@@ -1296,12 +1354,68 @@ void ELFObjectWriter::CompressDebugSections(MCAssembler &Asm,
     if (!SectionName.startswith(".debug_") || SectionName == ".debug_frame")
       continue;
 
-    CompressDebugSection(Asm, Layout, DefiningSymbols, Section, SD);
+    DebugSections.push_back(&SD);
+  }
+
+  // The sections are compressed independently of each other, on Pool if one
+  // is given. This only reads the fragments.
+  std::vector<std::unique_ptr<MCDataFragment>> CompressedFragments(
+      DebugSections.size());
+  {
+    std::unique_ptr<ThreadPoolTaskGroup> Group;
+    if (Pool)
+      Group.reset(new ThreadPoolTaskGroup(*Pool));
+    for (unsigned I = 0, E = DebugSections.size(); I != E; ++I) {
+      auto Compress = [=, &CompressedFragments, &DebugSections] {
+        CompressedFragments[I] = getCompressedFragment(
+            Type, is64Bit(), isLittleEndian(), *DebugSections[I]);
+      };
+      if (Group)
+        Group->async(Compress);
+      else
+        Compress();
+    }
+  }
+
+  DefiningSymbolMap DefiningSymbols;
+  for (MCSymbolData &SD : Asm.symbols())
+    if (MCFragment *F = SD.getFragment())
+      DefiningSymbols[F->getParent()].push_back(&SD);
+
+  for (unsigned I = 0, E = DebugSections.size(); I != E; ++I) {
+    // Leave the section as-is if the fragments could not be compressed.
+    if (!CompressedFragments[I])
+      continue;
+
+    MCSectionData &SD = *DebugSections[I];
+    ReplaceWithCompressedFragment(Asm, Layout, DefiningSymbols, SD,
+                                  std::move(CompressedFragments[I]));
+
+    const MCSectionELF &Section =
+        static_cast<const MCSectionELF &>(SD.getSection());
+    if (Type == DebugCompression::ZlibGnu) {
+      // Rename from .debug_* to .zdebug_*
+      Asm.getContext().renameELFSection(
+          &Section, (".z" + Section.getSectionName().drop_front(1)).str());
+      continue;
+    }
+
+    // SHF_COMPRESSED sections keep their name. The compression header records
+    // the original alignment, the section itself is aligned for the header.
+    CompressedSections.insert(&Section);
+    SD.setAlignment(is64Bit() ? 8 : 4);
   }
 }
 
 void ELFObjectWriter::WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
-                                       const RelMapTy &RelMap) {
+                                       const RelMapTy &RelMap,
+                                       ThreadPool *Pool) {
+  // The sections are created up front, and then each one is sorted and
+  // encoded independently of the others.
+  std::unique_ptr<ThreadPoolTaskGroup> Group;
+  if (Pool)
+    Group.reset(new ThreadPoolTaskGroup(*Pool));
+
   for (MCAssembler::iterator it = Asm.begin(), ie = Asm.end(); it != ie; ++it) {
     MCSectionData &RelSD = *it;
     const MCSectionELF &RelSection =
@@ -1316,7 +1430,13 @@ void ELFObjectWriter::WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
     RelSD.setAlignment(is64Bit() ? 8 : 4);
 
     MCDataFragment *F = new MCDataFragment(&RelSD);
-    WriteRelocationsFragment(Asm, F, &SD);
+    std::vector<ELFRelocationEntry> &Relocs = Relocations[&SD];
+    if (Group)
+      Group->async([=, &Asm, &Relocs] {
+        WriteRelocationsFragment(Asm, F, Relocs);
+      });
+    else
+      WriteRelocationsFragment(Asm, F, Relocs);
   }
 }
 
@@ -1356,11 +1476,9 @@ static void sortRelocs(const MCAssembler &Asm,
   array_pod_sort(Relocs.begin(), Relocs.end(), cmpRel);
 }
 
-void ELFObjectWriter::WriteRelocationsFragment(const MCAssembler &Asm,
-                                               MCDataFragment *F,
-                                               const MCSectionData *SD) {
-  std::vector<ELFRelocationEntry> &Relocs = Relocations[SD];
-
+void ELFObjectWriter::WriteRelocationsFragment(
+    const MCAssembler &Asm, MCDataFragment *F,
+    std::vector<ELFRelocationEntry> &Relocs) {
   sortRelocs(Asm, Relocs);
 
   for (unsigned i = 0, e = Relocs.size(); i != e; ++i) {
@@ -1443,7 +1561,10 @@ void ELFObjectWriter::CreateMetadataSections(
       static_cast<const MCSectionELF&>(it->getSection());
     ShStrTabBuilder.add(Section.getSectionName());
   }
-  ShStrTabBuilder.finalize(StringTableBuilder::ELF);
+  if (Asm.getContext().getAsmInfo()->fastStringTables())
+    ShStrTabBuilder.finalizeInOrder(StringTableBuilder::ELF);
+  else
+    ShStrTabBuilder.finalize(StringTableBuilder::ELF);
   F->getContents().append(ShStrTabBuilder.data().begin(),
                           ShStrTabBuilder.data().end());
 }
@@ -1570,9 +1691,12 @@ void ELFObjectWriter::writeSection(MCAssembler &Asm,
     }
   }
 
+  uint64_t Flags = Section.getFlags();
+  if (CompressedSections.count(&Section))
+    Flags |= ELF::SHF_COMPRESSED;
+
   WriteSecHdrEntry(ShStrTabBuilder.getOffset(Section.getSectionName()),
-                   Section.getType(),
-                   Section.getFlags(), 0, Offset, Size, sh_link, sh_info,
+                   Section.getType(), Flags, 0, Offset, Size, sh_link, sh_info,
                    Alignment, Section.getEntrySize());
 }
 
@@ -1626,6 +1750,46 @@ void ELFObjectWriter::WriteDataSectionData(MCAssembler &Asm,
   }
 }
 
+void ELFObjectWriter::writeSectionDataInParallel(
+    MCAssembler &Asm, const MCAsmLayout &Layout,
+    ArrayRef<const MCSectionELF *> Sections,
+    const SectionOffsetMapTy &SectionOffsetMap, uint64_t End,
+    ThreadPool &Pool) {
+  uint64_t Start = OS.tell();
+  // Padding between the sections stays zero.
+  std::vector<char> Buffer(End - Start);
+  {
+    ThreadPoolTaskGroup Group(Pool);
+    for (const MCSectionELF *Section : Sections) {
+      const MCSectionData &SD = Asm.getOrCreateSectionData(*Section);
+      char *Dest = Buffer.data() + (SectionOffsetMap.lookup(Section) - Start);
+      uint64_t Size = GetSectionFileSize(Layout, SD);
+      Group.async([=, &Asm, &Layout, &SD] {
+        if (IsELFMetaDataSection(SD)) {
+          char *Cur = Dest;
+          for (const MCFragment &F : SD) {
+            const SmallVectorImpl<char> &Contents =
+                cast<MCDataFragment>(F).getContents();
+            memcpy(Cur, Contents.data(), Contents.size());
+            Cur += Contents.size();
+          }
+          return;
+        }
+
+        SmallVector<char, 0> Data;
+        Data.reserve(Size);
+        raw_svector_ostream VecOS(Data);
+        SectionDataWriter Writer(VecOS, isLittleEndian());
+        Asm.writeSectionData(&SD, Layout, Writer);
+        VecOS.flush();
+        assert(Data.size() == Size && "Section data has the wrong size");
+        memcpy(Dest, Data.data(), Data.size());
+      });
+    }
+  }
+  OS.write(Buffer.data(), Buffer.size());
+}
+
 void ELFObjectWriter::writeSectionHeader(
     MCAssembler &Asm, const GroupMapTy &GroupMap, const MCAsmLayout &Layout,
     const SectionIndexMapTy &SectionIndexMap, const RelMapTy &RelMap,
@@ -1704,7 +1868,14 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
 
   unsigned NumUserSections = Asm.size();
 
-  CompressDebugSections(Asm, const_cast<MCAsmLayout &>(Layout));
+  // If requested, compress the debug sections, fill in the relocation sections
+  // and write the section data on several threads. The layout is final, so
+  // this only reads it.
+  ThreadPool *Pool = nullptr;
+  if (Asm.getContext().getAsmInfo()->parallelObjectWriting())
+    Pool = &*ObjectWritingPool;
+
+  CompressDebugSections(Asm, const_cast<MCAsmLayout &>(Layout), Pool);
 
   DenseMap<const MCSectionELF*, const MCSectionELF*> RelMap;
   const unsigned NumUserAndRelocSections = Asm.size();
@@ -1719,7 +1890,7 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
   computeSymbolTable(Asm, Layout, SectionIndexMap, RevGroupMap,
                      NumRegularSections);
 
-  WriteRelocations(Asm, const_cast<MCAsmLayout&>(Layout), RelMap);
+  WriteRelocations(Asm, const_cast<MCAsmLayout&>(Layout), RelMap, Pool);
 
   CreateMetadataSections(const_cast<MCAssembler&>(Asm),
                          const_cast<MCAsmLayout&>(Layout),
@@ -1748,6 +1919,7 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
   }
 
   FileOff = RoundUpToAlignment(FileOff, NaturalAlignment);
+  const uint64_t RegularSectionsEnd = FileOff;
 
   const unsigned SectionHeaderOffset = FileOff - HeaderSize;
 
@@ -1773,8 +1945,14 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
 
   // ... then the regular sections ...
   // + because of .shstrtab
-  for (unsigned i = 0; i < NumRegularSections + 1; ++i)
-    WriteDataSectionData(Asm, Layout, *Sections[i]);
+  ArrayRef<const MCSectionELF *> RegularSections(Sections.data(),
+                                                 NumRegularSections + 1);
+  if (Pool)
+    writeSectionDataInParallel(Asm, Layout, RegularSections, SectionOffsetMap,
+                               RegularSectionsEnd, *Pool);
+  else
+    for (const MCSectionELF *Section : RegularSections)
+      WriteDataSectionData(Asm, Layout, *Section);
 
   uint64_t Padding = OffsetToAlignment(OS.tell(), NaturalAlignment);
   WriteZeros(Padding);
@@ -1784,8 +1962,14 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
                      SectionOffsetMap);
 
   // ... and then the remaining sections ...
-  for (unsigned i = NumRegularSections + 1; i < NumSections; ++i)
-    WriteDataSectionData(Asm, Layout, *Sections[i]);
+  ArrayRef<const MCSectionELF *> RemainingSections =
+      makeArrayRef(Sections).slice(NumRegularSections + 1);
+  if (Pool)
+    writeSectionDataInParallel(Asm, Layout, RemainingSections,
+                               SectionOffsetMap, FileOff, *Pool);
+  else
+    for (const MCSectionELF *Section : RemainingSections)
+      WriteDataSectionData(Asm, Layout, *Section);
 }
 
 bool
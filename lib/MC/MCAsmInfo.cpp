@@ -103,7 +103,9 @@ MCAsmInfo::MCAsmInfo() {
   //   - The target subclasses for AArch64, ARM, and X86 handle these cases
   UseIntegratedAssembler = false;
 
-  CompressDebugSections = false;
+  CompressDebugSections = DebugCompression::None;
+  ParallelObjectWriting = false;
+  FastStringTables = false;
 }
 
 MCAsmInfo::~MCAsmInfo() {
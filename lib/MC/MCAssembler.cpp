@@ -28,6 +28,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <tuple>
 using namespace llvm;
@@ -53,6 +54,10 @@ STATISTIC(evaluateFixup, "Number of evaluated fixups");
 STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
+STATISTIC(SectionRelaxationSteps,
+          "Number of relaxation steps over a single section");
+STATISTIC(RelaxationChecks, "Number of fragments checked for relaxation");
+STATISTIC(MovedFragments, "Number of fragments moved after relaxation");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
 }
 }
@@ -94,10 +99,75 @@ void MCAsmLayout::invalidateFragmentsFrom(MCFragment *F) {
   // (if this is the first fragment, it will be NULL).
   const MCSectionData &SD = *F->getParent();
   LastValidFragment[&SD] = F->getPrevNode();
+
+  // The moved fragments will be laid out again instead.
+  MCFragment *Moved = FirstMovedFragment.lookup(&SD);
+  if (Moved && !isFragmentValid(Moved))
+    FirstMovedFragment.erase(&SD);
+}
+
+void MCAsmLayout::moveFragmentsAfter(MCFragment *F) {
+  // Fragments that haven't been laid out yet will follow F anyway.
+  if (!isFragmentValid(F))
+    return;
+  // F itself may still have to move.
+  ensureValid(F);
+  MCFragment *Next = F->getNextNode();
+  if (!Next || !isFragmentValid(Next))
+    return;
+
+  const MCSectionData &SD = *F->getParent();
+  MCFragment *Moved = FirstMovedFragment.lookup(&SD);
+  if (!Moved) {
+    FirstMovedFragment[&SD] = Next;
+    return;
+  }
+
+  // The fragments between F and the first moved one are up to date, but
+  // only for the old size of F. Move them right away, so that the out of
+  // date fragments stay together.
+  for (MCFragment *Cur = Next; Cur != Moved; Cur = Cur->getNextNode()) {
+    MCFragment *Prev = Cur->getPrevNode();
+    uint64_t Offset =
+        Prev->Offset + getAssembler().computeFragmentSize(*this, *Prev);
+    if (Offset == Cur->Offset)
+      return;
+    ++stats::MovedFragments;
+    Cur->Offset = Offset;
+  }
+}
+
+void MCAsmLayout::updateMovedFragments(const MCFragment *F) const {
+  const MCSectionData *SD = F->getParent();
+  for (;;) {
+    MCFragment *Moved = FirstMovedFragment.lookup(SD);
+    if (!Moved ||
+        (Moved->getLayoutOrder() > F->getLayoutOrder() && isFragmentValid(F)))
+      return;
+
+    MCFragment *Prev = Moved->getPrevNode();
+    uint64_t Offset =
+        Prev->Offset + getAssembler().computeFragmentSize(*this, *Prev);
+    // Computing the size may have brought this fragment up to date already.
+    if (FirstMovedFragment.lookup(SD) != Moved)
+      continue;
+
+    // The fragments after one that stays put don't move either.
+    MCFragment *Next = Moved->getNextNode();
+    if (Offset == Moved->Offset || !Next || !isFragmentValid(Next))
+      FirstMovedFragment.erase(SD);
+    else
+      FirstMovedFragment[SD] = Next;
+    if (Offset != Moved->Offset) {
+      ++stats::MovedFragments;
+      Moved->Offset = Offset;
+    }
+  }
 }
 
 void MCAsmLayout::ensureValid(const MCFragment *F) const {
   MCSectionData &SD = *F->getParent();
+  updateMovedFragments(F);
 
   MCFragment *Cur = LastValidFragment[&SD];
   if (!Cur)
@@ -677,9 +747,7 @@ static void writeFragmentContents(const MCFragment &F, MCObjectWriter *OW) {
 
 /// \brief Write the fragment \p F to the output file.
 static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
-                          const MCFragment &F) {
-  MCObjectWriter *OW = &Asm.getWriter();
-
+                          const MCFragment &F, MCObjectWriter *OW) {
   // FIXME: Embed in fragments instead?
   uint64_t FragmentSize = Asm.computeFragmentSize(Layout, F);
 
@@ -827,6 +895,12 @@ static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
 
 void MCAssembler::writeSectionData(const MCSectionData *SD,
                                    const MCAsmLayout &Layout) const {
+  writeSectionData(SD, Layout, getWriter());
+}
+
+void MCAssembler::writeSectionData(const MCSectionData *SD,
+                                   const MCAsmLayout &Layout,
+                                   MCObjectWriter &OW) const {
   // Ignore virtual sections.
   if (SD->getSection().isVirtualSection()) {
     assert(Layout.getSectionFileSize(SD) == 0 && "Invalid size for section!");
@@ -871,14 +945,14 @@ void MCAssembler::writeSectionData(const MCSectionData *SD,
     return;
   }
 
-  uint64_t Start = getWriter().getStream().tell();
+  uint64_t Start = OW.getStream().tell();
   (void)Start;
 
   for (MCSectionData::const_iterator it = SD->begin(), ie = SD->end();
        it != ie; ++it)
-    writeFragment(*this, Layout, *it);
+    writeFragment(*this, Layout, *it, &OW);
 
-  assert(getWriter().getStream().tell() - Start ==
+  assert(OW.getStream().tell() - Start ==
          Layout.getSectionAddressSize(SD));
 }
 
@@ -930,16 +1004,54 @@ void MCAssembler::Finish() {
       iFrag->setLayoutOrder(FragmentIndex++);
   }
 
-  // Layout until everything fits.
-  while (layoutOnce(Layout))
-    continue;
+  // Collect the fragments that relaxation may change.
+  std::vector<RelaxationWorklist> Worklists(SectionIndex);
+  for (MCAssembler::iterator it = begin(), ie = end(); it != ie; ++it) {
+    RelaxationWorklist &Worklist = Worklists[it->getOrdinal()];
+    for (MCSectionData::iterator iFrag = it->begin(), iFragEnd = it->end();
+         iFrag != iFragEnd; ++iFrag) {
+      switch (iFrag->getKind()) {
+      default:
+        break;
+      case MCFragment::FT_Relaxable:
+        assert(!getRelaxAll() &&
+               "Did not expect a MCRelaxableFragment in RelaxAll mode");
+        if (getBackend().mayNeedRelaxation(
+                cast<MCRelaxableFragment>(iFrag)->getInst()))
+          Worklist.Fragments.push_back(iFrag);
+        break;
+      case MCFragment::FT_Dwarf:
+      case MCFragment::FT_DwarfFrame:
+      case MCFragment::FT_LEB:
+        Worklist.Fragments.push_back(iFrag);
+        break;
+      case MCFragment::FT_Org:
+        // The size of an org fragment depends on where its target is.
+        Worklist.CanMoveFragments = false;
+        break;
+      }
+    }
+    // Bundle padding depends on the size of the fragment it precedes.
+    if (isBundlingEnabled())
+      Worklist.CanMoveFragments = false;
+  }
 
-  DEBUG_WITH_TYPE("mc-dump", {
-      llvm::errs() << "assembler backend - post-relaxation\n--\n";
-      dump(); });
+  {
+    // Time the layout along with the other assembler statistics.
+    NamedRegionTimer T("Layout and relaxation", "Assembler",
+                       AreStatisticsEnabled());
 
-  // Finalize the layout, including fragment lowering.
-  finishLayout(Layout);
+    // Layout until everything fits.
+    while (layoutOnce(Layout, Worklists))
+      continue;
+
+    DEBUG_WITH_TYPE("mc-dump", {
+        llvm::errs() << "assembler backend - post-relaxation\n--\n";
+        dump(); });
+
+    // Finalize the layout, including fragment lowering.
+    finishLayout(Layout);
+  }
 
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - final-layout\n--\n";
@@ -1080,55 +1192,65 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
-  // Holds the first fragment which needed relaxing during this layout. It will
-  // remain NULL if none were relaxed.
-  // When a fragment is relaxed, all the fragments following it should get
-  // invalidated because their offset is going to change.
-  MCFragment *FirstRelaxedFragment = nullptr;
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD,
+                                    RelaxationWorklist &Worklist) {
+  ++stats::SectionRelaxationSteps;
 
-  // Attempt to relax all the fragments in the section.
-  for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
+  bool WasRelaxed = false;
+  unsigned NumKept = 0;
+  for (MCFragment *F : Worklist.Fragments) {
+    ++stats::RelaxationChecks;
     bool RelaxedFrag = false;
-    switch(I->getKind()) {
+    bool Keep = true;
+    switch (F->getKind()) {
     default:
+      llvm_unreachable("Unexpected fragment in the relaxation worklist");
+    case MCFragment::FT_Relaxable: {
+      MCRelaxableFragment &RF = *cast<MCRelaxableFragment>(F);
+      RelaxedFrag = relaxInstruction(Layout, RF);
+      // Once relaxed as far as it goes, an instruction can't change again.
+      Keep = getBackend().mayNeedRelaxation(RF.getInst());
       break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
-      break;
+    }
     case MCFragment::FT_Dwarf:
       RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
+                                       *cast<MCDwarfLineAddrFragment>(F));
       break;
     case MCFragment::FT_DwarfFrame:
       RelaxedFrag =
         relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
+                                    *cast<MCDwarfCallFrameFragment>(F));
       break;
     case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
+      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(F));
       break;
     }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = I;
-  }
-  if (FirstRelaxedFragment) {
-    Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
-    return true;
+    if (Keep)
+      Worklist.Fragments[NumKept++] = F;
+    if (!RelaxedFrag)
+      continue;
+
+    // Later fragments in the worklist see the layout with this one relaxed.
+    WasRelaxed = true;
+    if (Worklist.CanMoveFragments)
+      Layout.moveFragmentsAfter(F);
+    else
+      Layout.invalidateFragmentsFrom(F);
   }
-  return false;
+  Worklist.Fragments.resize(NumKept);
+  return WasRelaxed;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout,
+                             std::vector<RelaxationWorklist> &Worklists) {
   ++stats::RelaxationSteps;
 
   bool WasRelaxed = false;
   for (iterator it = begin(), ie = end(); it != ie; ++it) {
     MCSectionData &SD = *it;
-    while (layoutSectionOnce(Layout, SD))
+    RelaxationWorklist &Worklist = Worklists[SD.getOrdinal()];
+    while (!Worklist.Fragments.empty() &&
+           layoutSectionOnce(Layout, SD, Worklist))
       WasRelaxed = true;
   }
 
@@ -8,33 +8,80 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/MC/StringTableBuilder.h"
-#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/COFF.h"
 #include "llvm/Support/Endian.h"
+#include <vector>
 
 using namespace llvm;
 
-static bool compareBySuffix(StringRef a, StringRef b) {
-  size_t sizeA = a.size();
-  size_t sizeB = b.size();
-  size_t len = std::min(sizeA, sizeB);
-  for (size_t i = 0; i < len; ++i) {
-    char ca = a[sizeA - i - 1];
-    char cb = b[sizeB - i - 1];
-    if (ca != cb)
-      return ca > cb;
+typedef StringMapEntry<size_t> StringEntry;
+
+// Returns the character Pos places from the end of the string, or -1 if the
+// string is not longer than Pos.
+static int charTailAt(const StringEntry *E, size_t Pos) {
+  StringRef S = E->getKey();
+  if (Pos >= S.size())
+    return -1;
+  return (unsigned char)S[S.size() - Pos - 1];
+}
+
+// Sorts the strings by their reversed contents, in descending order, so that a
+// string directly follows the longer strings it is a suffix of. This is a
+// three-way radix quicksort: unlike std::sort with a suffix comparison, it
+// never looks at a character again once it knows all strings in a range share
+// it.
+static void multikeySort(StringEntry **Begin, StringEntry **End, size_t Pos) {
+tailcall:
+  if (End - Begin <= 1)
+    return;
+
+  // Partition the strings by their character at Pos: [Begin, P) are greater
+  // than the pivot, [P, Q) are equal to it and [Q, End) are less than it.
+  std::swap(*Begin, Begin[(End - Begin) / 2]);
+  int Pivot = charTailAt(*Begin, Pos);
+  StringEntry **P = Begin;
+  StringEntry **Q = End;
+  for (StringEntry **R = Begin + 1; R < Q;) {
+    int C = charTailAt(*R, Pos);
+    if (C > Pivot)
+      std::swap(*P++, *R++);
+    else if (C < Pivot)
+      std::swap(*--Q, *R);
+    else
+      ++R;
+  }
+
+  multikeySort(Begin, P, Pos);
+  multikeySort(Q, End, Pos);
+  if (Pivot != -1) {
+    // multikeySort(P, Q, Pos + 1), without growing the stack.
+    Begin = P;
+    End = Q;
+    ++Pos;
+    goto tailcall;
   }
-  return sizeA > sizeB;
 }
 
 void StringTableBuilder::finalize(Kind kind) {
-  SmallVector<StringRef, 8> Strings;
-  Strings.reserve(StringIndexMap.size());
+  finalizeStringTable(kind, /*Optimize=*/true);
+}
 
-  for (auto i = StringIndexMap.begin(), e = StringIndexMap.end(); i != e; ++i)
-    Strings.push_back(i->getKey());
+void StringTableBuilder::finalizeInOrder(Kind kind) {
+  finalizeStringTable(kind, /*Optimize=*/false);
+}
+
+void StringTableBuilder::finalizeStringTable(Kind kind, bool Optimize) {
+  // The map already holds each string once. Work on its entries directly, so
+  // that recording the offsets doesn't have to hash the strings again.
+  std::vector<StringEntry *> Strings(StringIndexMap.size());
+  size_t Size = 0;
+  for (StringEntry &E : StringIndexMap) {
+    Strings[E.getValue()] = &E;
+    Size += E.getKeyLength() + 1;
+  }
 
-  std::sort(Strings.begin(), Strings.end(), compareBySuffix);
+  if (Optimize && !Strings.empty())
+    multikeySort(&Strings[0], &Strings[0] + Strings.size(), 0);
 
   switch (kind) {
   case ELF:
@@ -47,18 +94,20 @@ void StringTableBuilder::finalize(Kind kind) {
     StringTable.append(4, '\x00');
     break;
   }
+  StringTable.reserve(StringTable.size() + Size + 3);
 
   StringRef Previous;
-  for (StringRef s : Strings) {
+  for (StringEntry *E : Strings) {
+    StringRef s = E->getKey();
     if (kind == WinCOFF)
       assert(s.size() > COFF::NameSize && "Short string in COFF string table!");
 
-    if (Previous.endswith(s)) {
-      StringIndexMap[s] = StringTable.size() - 1 - s.size();
+    if (Optimize && Previous.endswith(s)) {
+      E->setValue(StringTable.size() - 1 - s.size());
       continue;
     }
 
-    StringIndexMap[s] = StringTable.size();
+    E->setValue(StringTable.size());
     StringTable += s;
     StringTable += '\x00';
     Previous = s;
@@ -17,6 +17,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 
 using namespace llvm;
 using namespace object;
@@ -110,6 +111,11 @@ uint64_t Archive::Child::getSize() const {
   return Data.size() - StartOfFile;
 }
 
+bool Archive::Child::isThinMember() const {
+  StringRef Name = getHeader()->getName();
+  return Parent->IsThin && Name != "/" && Name != "//";
+}
+
 uint64_t Archive::Child::getRawSize() const {
   return getHeader()->getSize();
 }
@@ -161,10 +167,26 @@ ErrorOr<StringRef> Archive::Child::getName() const {
                    + Parent->StringTable->getSize()))
       return object_error::parse_failed;
 
+    // The string table isn't NUL-terminated, so the end of the name has to be
+    // found before the end of the table.
+    StringRef Rest(addr, Parent->StringTable->Data.begin() +
+                             sizeof(ArchiveMemberHeader) +
+                             Parent->StringTable->getSize() - addr);
+
+    // Thin archives store relative paths, which end with a "/\n".
+    if (Parent->IsThin) {
+      StringRef::size_type End = Rest.find("/\n");
+      if (End == StringRef::npos)
+        return object_error::parse_failed;
+      return Rest.substr(0, End);
+    }
+
     // GNU long file names end with a /.
     if (Parent->kind() == K_GNU || Parent->kind() == K_MIPS64) {
-      StringRef::size_type End = StringRef(addr).find('/');
-      return StringRef(addr, End);
+      StringRef::size_type End = Rest.find('/');
+      if (End == StringRef::npos)
+        return object_error::parse_failed;
+      return Rest.substr(0, End);
     }
     return StringRef(addr);
   } else if (name.startswith("#1/")) {
@@ -185,7 +207,13 @@ ErrorOr<MemoryBufferRef> Archive::Child::getMemoryBufferRef() const {
   if (std::error_code EC = NameOrErr.getError())
     return EC;
   StringRef Name = NameOrErr.get();
-  return MemoryBufferRef(getBuffer(), Name);
+  if (!isThinMember())
+    return MemoryBufferRef(getBuffer(), Name);
+
+  ErrorOr<StringRef> BufOrErr = Parent->getThinMemberBuffer(*this);
+  if (std::error_code EC = BufOrErr.getError())
+    return EC;
+  return MemoryBufferRef(BufOrErr.get(), Name);
 }
 
 ErrorOr<std::unique_ptr<Binary>>
@@ -334,6 +362,30 @@ Archive::Archive(MemoryBufferRef Source, std::error_code &ec)
   ec = object_error::success;
 }
 
+ErrorOr<StringRef> Archive::getThinMemberBuffer(const Child &C) const {
+  std::lock_guard<std::mutex> Lock(ThinBuffersMutex);
+  std::unique_ptr<MemoryBuffer> &Buf = ThinBuffers[C.getChildOffset()];
+  if (Buf)
+    return Buf->getBuffer();
+
+  ErrorOr<StringRef> NameOrErr = C.getName();
+  if (std::error_code EC = NameOrErr.getError())
+    return EC;
+
+  // Relative member names are relative to the directory of the archive.
+  SmallString<128> FullName;
+  if (sys::path::is_relative(NameOrErr.get()))
+    FullName = sys::path::parent_path(Data.getBufferIdentifier());
+  sys::path::append(FullName, NameOrErr.get());
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(FullName.str(), -1, false);
+  if (std::error_code EC = BufOrErr.getError())
+    return EC;
+  Buf = std::move(BufOrErr.get());
+  return Buf->getBuffer();
+}
+
 Archive::child_iterator Archive::child_begin(bool SkipInternal) const {
   if (Data.getBufferSize() == 8) // empty archive.
     return child_end();
@@ -518,21 +570,32 @@ Archive::symbol_iterator Archive::symbol_end() const {
   return symbol_iterator(Symbol(this, symbol_count, 0));
 }
 
-Archive::child_iterator Archive::findSym(StringRef name) const {
+void Archive::buildSymbolIndex() const {
   Archive::symbol_iterator bs = symbol_begin();
   Archive::symbol_iterator es = symbol_end();
+  // DenseMap grows past 3/4 load, size the buckets for every symbol upfront.
+  SymbolIndex.resize(uint64_t(es->SymbolIndex) * 4 / 3 + 1);
 
   for (; bs != es; ++bs) {
-    StringRef SymName = bs->getName();
-    if (SymName == name) {
-      ErrorOr<Archive::child_iterator> ResultOrErr = bs->getMember();
-      // FIXME: Should we really eat the error?
-      if (ResultOrErr.getError())
-        return child_end();
-      return ResultOrErr.get();
-    }
+    // The names point into the archive buffer, which outlives the index.
+    // Keep the first symbol with a given name, like a linear search would.
+    SymbolIndex.insert(std::make_pair(
+        bs->getName(), std::make_pair(bs->SymbolIndex, bs->StringIndex)));
   }
-  return child_end();
+}
+
+Archive::child_iterator Archive::findSym(StringRef name) const {
+  std::call_once(SymbolIndexFlag, [this] { buildSymbolIndex(); });
+
+  auto I = SymbolIndex.find(name);
+  if (I == SymbolIndex.end())
+    return child_end();
+  Symbol Sym(this, I->second.first, I->second.second);
+  ErrorOr<Archive::child_iterator> ResultOrErr = Sym.getMember();
+  // FIXME: Should we really eat the error?
+  if (ResultOrErr.getError())
+    return child_end();
+  return ResultOrErr.get();
 }
 
 bool Archive::hasSymbolTable() const {
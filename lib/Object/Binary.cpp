@@ -75,8 +75,11 @@ ErrorOr<std::unique_ptr<Binary>> object::createBinary(MemoryBufferRef Buffer,
 }
 
 ErrorOr<OwningBinary<Binary>> object::createBinary(StringRef Path) {
+  // Object files don't need a null terminator, so large ones are always
+  // mapped rather than read into memory, and only the pages that are used
+  // get loaded.
   ErrorOr<std::unique_ptr<MemoryBuffer>> FileOrErr =
-      MemoryBuffer::getFileOrSTDIN(Path);
+      MemoryBuffer::getFileOrSTDIN(Path, -1, /*RequiresNullTerminator=*/false);
   if (std::error_code EC = FileOrErr.getError())
     return EC;
   std::unique_ptr<MemoryBuffer> &Buffer = FileOrErr.get();
@@ -182,11 +182,11 @@ CoverageMapping::load(CoverageMappingReader &CoverageReader,
                       IndexedInstrProfReader &ProfileReader) {
   auto Coverage = std::unique_ptr<CoverageMapping>(new CoverageMapping());
 
-  std::vector<uint64_t> Counts;
   for (const auto &Record : CoverageReader) {
     CounterMappingContext Ctx(Record.Expressions);
 
-    Counts.clear();
+    // The counts are only used until the next lookup, no need to copy them.
+    ArrayRef<uint64_t> Counts;
     if (std::error_code EC = ProfileReader.getFunctionCounts(
             Record.FunctionName, Record.FunctionHash, Counts)) {
       if (EC == instrprof_error::hash_mismatch) {
@@ -15,6 +15,8 @@
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "InstrProfIndexed.h"
 #include "llvm/ProfileData/InstrProf.h"
+#include "llvm/Support/AlignOf.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace llvm;
@@ -302,6 +304,29 @@ InstrProfLookupTrait::ComputeHash(StringRef K) {
   return IndexedInstrProf::ComputeHash(HashType, K);
 }
 
+InstrProfLookupTrait::data_type
+InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
+                               offset_type N) {
+  DataBuffer.clear();
+  if (N % sizeof(uint64_t))
+    // The data is corrupt, don't try to read it.
+    return data_type("", DataBuffer);
+
+  // We just treat the data as opaque here. It's simpler to handle in
+  // IndexedInstrProfReader.
+  unsigned NumEntries = N / sizeof(uint64_t);
+  if (sys::IsLittleEndianHost &&
+      reinterpret_cast<uintptr_t>(D) % alignOf<uint64_t>() == 0)
+    return data_type(K, makeArrayRef(
+                            reinterpret_cast<const uint64_t *>(D), NumEntries));
+
+  using namespace support;
+  DataBuffer.reserve(NumEntries);
+  for (unsigned I = 0; I < NumEntries; ++I)
+    DataBuffer.push_back(endian::readNext<uint64_t, little, unaligned>(D));
+  return data_type(K, DataBuffer);
+}
+
 bool IndexedInstrProfReader::hasFormat(const MemoryBuffer &DataBuffer) {
   if (DataBuffer.getBufferSize() < 8)
     return false;
@@ -349,14 +374,46 @@ std::error_code IndexedInstrProfReader::readHeader() {
   return success();
 }
 
-std::error_code IndexedInstrProfReader::getFunctionCounts(
-    StringRef FuncName, uint64_t FuncHash, std::vector<uint64_t> &Counts) {
+std::error_code
+IndexedInstrProfReader::lookupRecord(StringRef FuncName,
+                                     const CachedRecord *&Record) {
+  auto Cached = RecordCacheIndex.find(FuncName);
+  if (Cached != RecordCacheIndex.end()) {
+    // Move it to the front, as the most recently used.
+    RecordCache.splice(RecordCache.begin(), RecordCache, Cached->second);
+    Record = &RecordCache.front();
+    return success();
+  }
+
   auto Iter = Index->find(FuncName);
   if (Iter == Index->end())
     return error(instrprof_error::unknown_function);
 
-  // Found it. Look for counters with the right hash.
+  // Found it. Reuse the least recently used entry if the cache is full.
+  if (RecordCache.size() >= RecordCacheSize) {
+    if (RecordCache.back().Name.data())
+      RecordCacheIndex.erase(RecordCache.back().Name);
+    RecordCache.splice(RecordCache.begin(), RecordCache,
+                       std::prev(RecordCache.end()));
+  } else {
+    RecordCache.emplace_front();
+  }
+  CachedRecord &Entry = RecordCache.front();
+  // Don't leave a partially decoded entry behind if the data is bogus.
+  Entry.Name = StringRef();
+  Entry.Storage.clear();
+  Entry.Counts.clear();
+
   ArrayRef<uint64_t> Data = (*Iter).Data;
+  // The data only needs to be copied if it was decoded into the lookup
+  // trait's buffer, which the next lookup overwrites.
+  if (Data.data() < (const void *)DataBuffer->getBufferStart() ||
+      Data.data() >= (const void *)DataBuffer->getBufferEnd()) {
+    Entry.Storage.assign(Data.begin(), Data.end());
+    Data = Entry.Storage;
+  }
+
+  // Split the data per function hash.
   uint64_t NumCounts;
   for (uint64_t I = 0, E = Data.size(); I != E; I += NumCounts) {
     // The function hash comes first.
@@ -368,15 +425,47 @@ std::error_code IndexedInstrProfReader::getFunctionCounts(
     // If we have more counts than data, this is bogus.
     if (I + NumCounts > E)
       return error(instrprof_error::malformed);
-    // Check for a match and fill the vector if there is one.
-    if (FoundHash == FuncHash) {
-      Counts = Data.slice(I, NumCounts);
+    Entry.Counts.push_back(std::make_pair(FoundHash, Data.slice(I, NumCounts)));
+  }
+  Entry.Name = (*Iter).Name;
+  RecordCacheIndex[Entry.Name] = RecordCache.begin();
+  Record = &Entry;
+  return success();
+}
+
+std::error_code IndexedInstrProfReader::getFunctionCounts(
+    StringRef FuncName, uint64_t FuncHash, ArrayRef<uint64_t> &Counts) {
+  const CachedRecord *Record;
+  if (std::error_code EC = lookupRecord(FuncName, Record))
+    return EC;
+
+  // Look for counters with the right hash.
+  for (const auto &HashAndCounts : Record->Counts)
+    if (HashAndCounts.first == FuncHash) {
+      Counts = HashAndCounts.second;
       return success();
     }
-  }
   return error(instrprof_error::hash_mismatch);
 }
 
+std::error_code IndexedInstrProfReader::getFunctionCounts(
+    StringRef FuncName, uint64_t FuncHash, std::vector<uint64_t> &Counts) {
+  ArrayRef<uint64_t> Data;
+  if (std::error_code EC = getFunctionCounts(FuncName, FuncHash, Data))
+    return EC;
+  Counts = Data;
+  return success();
+}
+
+void IndexedInstrProfReader::setRecordCacheSize(unsigned Size) {
+  RecordCacheSize = std::max(1u, Size);
+  while (RecordCache.size() > RecordCacheSize) {
+    if (RecordCache.back().Name.data())
+      RecordCacheIndex.erase(RecordCache.back().Name);
+    RecordCache.pop_back();
+  }
+}
+
 std::error_code
 IndexedInstrProfReader::readNextRecord(InstrProfRecord &Record) {
   // Are we out of records?
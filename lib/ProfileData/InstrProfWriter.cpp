@@ -106,6 +106,32 @@ InstrProfWriter::addFunctionCounts(StringRef FunctionName,
   return instrprof_error::success;
 }
 
+void InstrProfWriter::mergeRecordsFromWriter(
+    InstrProfWriter &&IPW,
+    function_ref<void(StringRef FunctionName, uint64_t FunctionHash,
+                      std::error_code EC)> Warn) {
+  for (auto I = IPW.FunctionData.begin(), E = IPW.FunctionData.end();
+       I != E;) {
+    auto Cur = I;
+    ++I;
+    StringRef FunctionName = Cur->getKey();
+    auto Where = FunctionData.find(FunctionName);
+    if (Where == FunctionData.end()) {
+      // We've never seen this function, just take its counts.
+      FunctionData[FunctionName] = std::move(Cur->getValue());
+    } else {
+      for (const auto &Counts : Cur->getValue())
+        if (std::error_code EC =
+                addFunctionCounts(FunctionName, Counts.first, Counts.second))
+          Warn(FunctionName, Counts.first, EC);
+    }
+    IPW.FunctionData.erase(Cur);
+  }
+  if (IPW.MaxFunctionCount > MaxFunctionCount)
+    MaxFunctionCount = IPW.MaxFunctionCount;
+  IPW.MaxFunctionCount = 0;
+}
+
 std::pair<uint64_t, uint64_t> InstrProfWriter::writeImpl(raw_ostream &OS) {
   OnDiskChainedHashTableGenerator<InstrProfRecordTrait> Generator;
 
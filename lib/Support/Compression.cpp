@@ -19,6 +19,8 @@
 #if LLVM_ENABLE_ZLIB == 1 && HAVE_ZLIB_H
 #include <zlib.h>
 #endif
+#include <algorithm>
+#include <limits>
 
 using namespace llvm;
 
@@ -61,6 +63,59 @@ zlib::Status zlib::compress(StringRef InputBuffer,
   return Res;
 }
 
+zlib::Status zlib::compress(ArrayRef<StringRef> InputBuffers,
+                            SmallVectorImpl<char> &CompressedBuffer,
+                            CompressionLevel Level) {
+  z_stream Stream;
+  Stream.zalloc = Z_NULL;
+  Stream.zfree = Z_NULL;
+  Stream.opaque = Z_NULL;
+  int Res = ::deflateInit(&Stream, encodeZlibCompressionLevel(Level));
+  if (Res != Z_OK)
+    return encodeZlibReturnValue(Res);
+
+  // The output grows in chunks of at least this size.
+  const size_t ChunkSize = 64 * 1024;
+  // avail_in and avail_out are only a uInt, so larger buffers are handed to
+  // deflate in slices of at most this size.
+  const size_t MaxSlice = std::numeric_limits<uInt>::max();
+  size_t Start = CompressedBuffer.size();
+  size_t Written = Start;
+  for (size_t I = 0, E = InputBuffers.size(); I <= E; ++I) {
+    bool Last = I == E;
+    StringRef Input = Last ? StringRef() : InputBuffers[I];
+    // deflate can't make progress on empty input without flushing.
+    if (!Last && Input.empty())
+      continue;
+    do {
+      StringRef Slice = Input.substr(0, MaxSlice);
+      Input = Input.substr(Slice.size());
+      Stream.next_in = (Bytef *)Slice.data();
+      Stream.avail_in = Slice.size();
+      do {
+        if (CompressedBuffer.size() == Written)
+          CompressedBuffer.resize(
+              Written + std::max(ChunkSize, (Written - Start) / 2));
+        size_t Available =
+            std::min(CompressedBuffer.size() - Written, MaxSlice);
+        Stream.next_out = (Bytef *)CompressedBuffer.data() + Written;
+        Stream.avail_out = Available;
+        Res = ::deflate(&Stream, Last ? Z_FINISH : Z_NO_FLUSH);
+        Written += Available - Stream.avail_out;
+      } while (Res == Z_OK && (Last || Stream.avail_in != 0));
+    } while (Res == Z_OK && !Input.empty());
+    if (Res != Z_OK && Res != Z_STREAM_END)
+      break;
+  }
+  ::deflateEnd(&Stream);
+
+  // Tell MemorySanitizer that zlib output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented ZLib.
+  __msan_unpoison(CompressedBuffer.data() + Start, Written - Start);
+  CompressedBuffer.resize(Written);
+  return Res == Z_STREAM_END ? StatusOK : encodeZlibReturnValue(Res);
+}
+
 zlib::Status zlib::uncompress(StringRef InputBuffer,
                               SmallVectorImpl<char> &UncompressedBuffer,
                               size_t UncompressedSize) {
@@ -86,6 +141,11 @@ zlib::Status zlib::compress(StringRef InputBuffer,
                             CompressionLevel Level) {
   return zlib::StatusUnsupported;
 }
+zlib::Status zlib::compress(ArrayRef<StringRef> InputBuffers,
+                            SmallVectorImpl<char> &CompressedBuffer,
+                            CompressionLevel Level) {
+  return zlib::StatusUnsupported;
+}
 zlib::Status zlib::uncompress(StringRef InputBuffer,
                               SmallVectorImpl<char> &UncompressedBuffer,
                               size_t UncompressedSize) {
@@ -15,8 +15,10 @@
 #include "llvm/Config/config.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 using namespace sys;
@@ -71,6 +73,11 @@ Optional<std::string> Process::FindInEnvPath(const std::string& EnvName,
   return FoundPath;
 }
 
+void Process::PrintMemoryUsage(raw_ostream &OS) {
+  OS << format("rss=%.1fMB peak-rss=%.1fMB\n",
+               double(GetResidentMemoryUsage()) / (1 << 20),
+               double(GetPeakMemoryUsage()) / (1 << 20));
+}
 
 #define COLOR(FGBG, CODE, BOLD) "\033[0;" BOLD FGBG CODE "m"
 
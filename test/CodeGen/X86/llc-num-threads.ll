@@ -0,0 +1,20 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj -j 2 %s -o %t.o
+; RUN: llvm-nm %t.o.0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t.o.1 | FileCheck --check-prefix=CHECK1 %s
+; RUN: not llc -mtriple=x86_64-unknown-linux-gnu -j 0 %s -o %t.s 2>&1 \
+; RUN:   | FileCheck --check-prefix=ZERO %s
+
+; ZERO: -num-threads must be at least 1
+
+; CHECK0-DAG: U bar
+; CHECK0-DAG: T foo
+; CHECK1-DAG: T bar
+
+define void @foo() {
+  call void @bar()
+  ret void
+}
+
+define void @bar() {
+  ret void
+}
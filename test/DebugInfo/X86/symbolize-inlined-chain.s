@@ -0,0 +1,130 @@
+# Check which subroutines llvm-symbolizer reports for an address when DIEs of
+# different functions cover it, or are nested in the DIE of another function.
+
+# RUN: llvm-mc -triple=x86_64-pc-linux -filetype=obj %s -o %t.o
+# RUN: echo "0x2 0x6 0x14 0x24" | tr ' ' '\n' \
+# RUN:   | llvm-symbolizer -inlining -obj=%t.o | FileCheck %s
+
+# An address in outer, and one in a call to inl that was inlined into it.
+# CHECK:      outer
+# CHECK-NEXT: :0
+# CHECK-NEXT: {{^$}}
+# CHECK-NEXT: inl
+# CHECK-NEXT: :0
+# CHECK-NEXT: outer
+# CHECK-NEXT: :0
+# CHECK-NEXT: {{^$}}
+
+# nested is a separate function whose DIE is a child of outer's, such as a
+# member function of a local class. outer doesn't cover its code.
+# CHECK-NEXT: nested
+# CHECK-NEXT: :0
+# CHECK-NEXT: {{^$}}
+
+# icf1 and icf2 were folded into the same code. The first DIE wins.
+# CHECK-NEXT: icf1
+# CHECK-NEXT: :0
+# CHECK-NEXT: {{^$}}
+
+	.text
+outer:
+	.fill	16, 1, 0x90
+nested:
+	.fill	16, 1, 0x90
+icf:
+	.fill	16, 1, 0x90
+.Ltext_end:
+
+	.section	.debug_abbrev,"",@progbits
+	.byte	1                       # Abbreviation Code
+	.byte	17                      # DW_TAG_compile_unit
+	.byte	1                       # DW_CHILDREN_yes
+	.byte	3                       # DW_AT_name
+	.byte	8                       # DW_FORM_string
+	.byte	17                      # DW_AT_low_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	18                      # DW_AT_high_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	2                       # Abbreviation Code
+	.byte	46                      # DW_TAG_subprogram
+	.byte	1                       # DW_CHILDREN_yes
+	.byte	3                       # DW_AT_name
+	.byte	8                       # DW_FORM_string
+	.byte	17                      # DW_AT_low_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	18                      # DW_AT_high_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	3                       # Abbreviation Code
+	.byte	46                      # DW_TAG_subprogram
+	.byte	0                       # DW_CHILDREN_no
+	.byte	3                       # DW_AT_name
+	.byte	8                       # DW_FORM_string
+	.byte	17                      # DW_AT_low_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	18                      # DW_AT_high_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	4                       # Abbreviation Code
+	.byte	46                      # DW_TAG_subprogram
+	.byte	0                       # DW_CHILDREN_no
+	.byte	3                       # DW_AT_name
+	.byte	8                       # DW_FORM_string
+	.byte	32                      # DW_AT_inline
+	.byte	11                      # DW_FORM_data1
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	5                       # Abbreviation Code
+	.byte	29                      # DW_TAG_inlined_subroutine
+	.byte	0                       # DW_CHILDREN_no
+	.byte	49                      # DW_AT_abstract_origin
+	.byte	19                      # DW_FORM_ref4
+	.byte	17                      # DW_AT_low_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	18                      # DW_AT_high_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	0                       # EOM(3)
+
+	.section	.debug_info,"",@progbits
+.Lcu_begin:
+	.long	.Lcu_end-.Lcu_begin-4   # Length of Unit
+	.short	4                       # DWARF version number
+	.long	0                       # Offset Into Abbrev. Section
+	.byte	8                       # Address Size (in bytes)
+	.byte	1                       # DW_TAG_compile_unit
+	.asciz	"test.c"                # DW_AT_name
+	.quad	outer                   # DW_AT_low_pc
+	.quad	.Ltext_end              # DW_AT_high_pc
+	.byte	2                       # DW_TAG_subprogram
+	.asciz	"outer"                 # DW_AT_name
+	.quad	outer                   # DW_AT_low_pc
+	.quad	nested                  # DW_AT_high_pc
+	.byte	5                       # DW_TAG_inlined_subroutine
+	.long	.Linl-.Lcu_begin        # DW_AT_abstract_origin
+	.quad	outer+4                 # DW_AT_low_pc
+	.quad	outer+8                 # DW_AT_high_pc
+	.byte	3                       # DW_TAG_subprogram
+	.asciz	"nested"                # DW_AT_name
+	.quad	nested                  # DW_AT_low_pc
+	.quad	icf                     # DW_AT_high_pc
+	.byte	0                       # End Of Children Mark
+	.byte	3                       # DW_TAG_subprogram
+	.asciz	"icf1"                  # DW_AT_name
+	.quad	icf                     # DW_AT_low_pc
+	.quad	.Ltext_end              # DW_AT_high_pc
+	.byte	3                       # DW_TAG_subprogram
+	.asciz	"icf2"                  # DW_AT_name
+	.quad	icf                     # DW_AT_low_pc
+	.quad	.Ltext_end              # DW_AT_high_pc
+.Linl:
+	.byte	4                       # DW_TAG_subprogram
+	.asciz	"inl"                   # DW_AT_name
+	.byte	1                       # DW_AT_inline
+	.byte	0                       # End Of Children Mark
+.Lcu_end:
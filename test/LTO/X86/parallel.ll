@@ -0,0 +1,37 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: llvm-lto -disable-opt -exported-symbol=foo -exported-symbol=bar -j2 -o %t.o %t.bc
+; RUN: llvm-nm %t.o.0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t.o.1 | FileCheck --check-prefix=CHECK1 %s
+; RUN: not llvm-lto -exported-symbol=foo -j0 -o %t.o %t.bc 2>&1 \
+; RUN:   | FileCheck --check-prefix=ZERO %s
+
+; ZERO: -j must be at least 1
+
+; Each function is defined in exactly one partition and referenced from the
+; other one. The internal @baz is externalized so both partitions can use it.
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; CHECK0-DAG: U bar
+; CHECK0-DAG: U baz
+; CHECK0-DAG: T foo
+; CHECK1-DAG: T bar
+; CHECK1-DAG: T baz
+; CHECK1-DAG: U foo
+
+define void @foo() {
+  call void @bar()
+  call void @baz()
+  ret void
+}
+
+define void @bar() {
+  call void @foo()
+  call void @baz()
+  ret void
+}
+
+define internal void @baz() {
+  ret void
+}
@@ -0,0 +1,22 @@
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor, i8* null }]
+@used_gv = global i32 1
+@unused_gv = global i32 2
+
+define void @ctor() {
+  ret void
+}
+
+define i32 @used() {
+  %r = call i32 @used_indirectly()
+  ret i32 %r
+}
+
+define i32 @used_indirectly() {
+  %v = load i32, i32* @used_gv
+  ret i32 %v
+}
+
+define i32 @unused() {
+  %v = load i32, i32* @unused_gv
+  ret i32 %v
+}
@@ -0,0 +1,5 @@
+@w = weak global i32 1
+
+define i32 @b() {
+  ret i32 2
+}
@@ -0,0 +1,6 @@
+@w = weak global i32 2
+
+define i32 @c() {
+  %r = load i32, i32* @w
+  ret i32 %r
+}
@@ -0,0 +1,6 @@
+@dv = global i32 4
+
+define i32 @d() {
+  %r = load i32, i32* @dv
+  ret i32 %r
+}
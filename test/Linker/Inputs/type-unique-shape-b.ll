@@ -0,0 +1,3 @@
+%node = type { %node*, i64 }
+
+@b = global %node zeroinitializer
@@ -0,0 +1,3 @@
+%node = type { %node*, i64 }
+
+@c = global %node zeroinitializer
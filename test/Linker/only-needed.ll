@@ -0,0 +1,28 @@
+; RUN: llvm-as %S/Inputs/only-needed.ll -o %t.needed.bc
+; RUN: llvm-as %s -o %t.main.bc
+; RUN: llvm-link -only-needed %t.main.bc %t.needed.bc -S | FileCheck %s
+; RUN: llvm-link -only-needed %t.main.bc %t.needed.bc -S \
+; RUN:   | FileCheck %s --check-prefix=UNUSED
+; RUN: llvm-link %t.main.bc %t.needed.bc -S | FileCheck %s --check-prefix=ALL
+
+; With -only-needed, only the definitions reachable from the first module are
+; linked in from the second one. Appending variables are always linked.
+
+; CHECK-DAG: @llvm.global_ctors = appending global
+; CHECK-DAG: @used_gv = global i32 1
+; CHECK-DAG: define i32 @main()
+; CHECK-DAG: define i32 @used()
+; CHECK-DAG: define i32 @used_indirectly()
+; CHECK-DAG: define void @ctor()
+
+; UNUSED-NOT: @unused
+
+; ALL-DAG: @unused_gv = global i32 2
+; ALL-DAG: define i32 @unused()
+
+declare i32 @used()
+
+define i32 @main() {
+  %r = call i32 @used()
+  ret i32 %r
+}
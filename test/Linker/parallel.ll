@@ -0,0 +1,38 @@
+; RUN: llvm-link %s %S/Inputs/parallel-b.ll %S/Inputs/parallel-c.ll \
+; RUN:   %S/Inputs/parallel-d.ll -S -o %t.serial
+; RUN: FileCheck %s < %t.serial
+; RUN: llvm-link -j 2 %s %S/Inputs/parallel-b.ll %S/Inputs/parallel-c.ll \
+; RUN:   %S/Inputs/parallel-d.ll -S -o %t.parallel
+; RUN: diff %t.serial %t.parallel
+; RUN: llvm-link -j 3 %s %S/Inputs/parallel-b.ll %S/Inputs/parallel-c.ll \
+; RUN:   %S/Inputs/parallel-d.ll -S -o %t.parallel
+; RUN: diff %t.serial %t.parallel
+; RUN: llvm-link -j 8 %s %S/Inputs/parallel-b.ll %S/Inputs/parallel-c.ll \
+; RUN:   %S/Inputs/parallel-d.ll -S -o %t.parallel
+; RUN: diff %t.serial %t.parallel
+; RUN: not llvm-link -j 2 -only-needed %s %S/Inputs/parallel-b.ll 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=ONLY-NEEDED
+
+; Linking the inputs in parallel runs resolves symbols the same way as linking
+; them one by one: the first weak definition of @w is kept, whichever run it is
+; in, and calls across runs resolve to the definitions. Nothing has to be
+; renamed here, so the output is the same as well.
+
+; CHECK: @w = weak global i32 0
+; CHECK: @dv = global i32 4
+; CHECK: define i32 @a()
+; CHECK-NEXT: call i32 @d()
+; CHECK: define i32 @b()
+; CHECK: define i32 @c()
+; CHECK: define i32 @d()
+
+; ONLY-NEEDED: -only-needed can't be used with -num-threads
+
+@w = weak global i32 0
+
+declare i32 @d()
+
+define i32 @a() {
+  %r = call i32 @d()
+  ret i32 %r
+}
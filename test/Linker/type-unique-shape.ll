@@ -0,0 +1,19 @@
+; RUN: llvm-link -S %s %p/Inputs/type-unique-shape-b.ll \
+; RUN:   %p/Inputs/type-unique-shape-c.ll | FileCheck %s
+
+; The second and third modules agree on a recursive %node type that differs
+; from the one in the first module. The third module's type is not isomorphic
+; to the destination type with the same name, but it has to be unified with
+; the copy that came from the second module rather than being copied again.
+
+; CHECK:      %node = type { %node*, i32 }
+; CHECK-NEXT: %[[NODE64:node\.[0-9]+]] = type { %[[NODE64]]*, i64 }
+; CHECK-NOT:  = type
+
+; CHECK: @a = global %node zeroinitializer
+; CHECK: @b = global %[[NODE64]] zeroinitializer
+; CHECK: @c = global %[[NODE64]] zeroinitializer
+
+%node = type { %node*, i32 }
+
+@a = global %node zeroinitializer
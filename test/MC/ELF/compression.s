@@ -3,6 +3,20 @@
 // RUN: llvm-dwarfdump -debug-dump=info %t | FileCheck --check-prefix=INFO %s
 // RUN: llvm-mc -filetype=obj -compress-debug-sections -triple i386-pc-linux-gnu < %s \
 // RUN:     | llvm-readobj -symbols - | FileCheck --check-prefix=386-SYMBOLS %s
+// RUN: llvm-mc -filetype=obj -compress-debug-sections=zlib-gnu -triple x86_64-pc-linux-gnu < %s -o %t.gnu
+// RUN: cmp %t %t.gnu
+
+// RUN: llvm-mc -filetype=obj -compress-debug-sections=zlib -triple x86_64-pc-linux-gnu < %s -o %t.gabi
+// RUN: llvm-readobj -s %t.gabi | FileCheck --check-prefix=GABI %s
+// RUN: llvm-dwarfdump -debug-dump=info %t.gabi | FileCheck --check-prefix=INFO %s
+// RUN: llvm-mc -filetype=obj -compress-debug-sections=zlib -triple i386-pc-linux-gnu < %s -o %t.gabi32
+// RUN: llvm-readobj -s %t.gabi32 | FileCheck --check-prefix=GABI32 %s
+// RUN: llvm-dwarfdump -debug-dump=info %t.gabi32 | FileCheck --check-prefix=INFO %s
+
+// The sections are compressed on several threads with the same result.
+// RUN: llvm-mc -filetype=obj -compress-debug-sections=zlib -triple x86_64-pc-linux-gnu < %s -o %t.par \
+// RUN:     -parallel-object-writing -threads=4
+// RUN: cmp %t.gabi %t.par
 
 // REQUIRES: zlib
 
@@ -27,6 +41,27 @@
 // Decompress one valid dwarf section just to check that this roundtrips
 // INFO: 0x00000000: Compile Unit: length = 0x0000000c version = 0x0004 abbr_offset = 0x0000 addr_size = 0x08 (next unit at 0x00000010)
 
+// SHF_COMPRESSED sections keep their name and are aligned for their header,
+// which takes too much space for the line table to be worth compressing.
+// GABI:      Name: .debug_line
+// GABI-NEXT: Type: SHT_PROGBITS
+// GABI-NEXT: Flags [ (0x0)
+// GABI-NEXT: ]
+// GABI:      Name: .debug_str
+// GABI-NEXT: Type: SHT_PROGBITS
+// GABI-NEXT: Flags [
+// GABI-NEXT:   SHF_COMPRESSED
+// GABI-NEXT:   SHF_MERGE
+// GABI-NEXT:   SHF_STRINGS
+// GABI-NEXT: ]
+// GABI:      AddressAlignment: 8
+
+// GABI32:      Name: .debug_str
+// GABI32-NEXT: Type: SHT_PROGBITS
+// GABI32-NEXT: Flags [
+// GABI32-NEXT:   SHF_COMPRESSED
+// GABI32:      AddressAlignment: 4
+
 // In x86 32 bit named symbols are used for temporary symbols in merge
 // sections, so make sure we handle symbols inside compressed sections
 // 386-SYMBOLS: Name: .Linfo_string0
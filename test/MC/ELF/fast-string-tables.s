@@ -0,0 +1,25 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - | \
+// RUN:   llvm-readobj -s -section-data | FileCheck %s --check-prefix=MERGED
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - \
+// RUN:   -fast-string-tables | \
+// RUN:   llvm-readobj -s -section-data | FileCheck %s --check-prefix=INORDER
+
+// By default "foo" shares the tail of "barfoo" in .strtab. With
+// -fast-string-tables the strings are laid out in the order they were added
+// and nothing is shared.
+
+        .globl barfoo
+        .globl foo
+barfoo:
+foo:
+        retq
+
+// MERGED:      Name: .strtab
+// MERGED:      SectionData (
+// MERGED-NEXT:   0000: 00626172 666F6F00 |.barfoo.|
+// MERGED-NEXT: )
+
+// INORDER:      Name: .strtab
+// INORDER:      SectionData (
+// INORDER-NEXT:   0000: 00626172 666F6F00 666F6F00 |.barfoo.foo.|
+// INORDER-NEXT: )
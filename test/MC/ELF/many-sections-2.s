@@ -1,6 +1,10 @@
 // RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t
 // RUN: llvm-readobj -s %t | FileCheck --check-prefix=SECTIONS %s
 // RUN: llvm-readobj -t %t | FileCheck --check-prefix=SYMBOLS %s
+// RUN: llvm-readobj -t -stats %t 2>&1 >/dev/null | FileCheck --check-prefix=STATS %s
+// RUN: llvm-size -stats %t 2>&1 >/dev/null | FileCheck --check-prefix=STATS %s
+
+// STATS: rss={{[0-9.]+}}MB peak-rss={{[0-9.]+}}MB
 
 // Test that we create a .symtab_shndx if a symbol points to a section
 // numbered SHN_LORESERVE (0xFF00) or higher.
@@ -0,0 +1,61 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.par \
+// RUN:   -parallel-object-writing -threads=4
+// RUN: cmp %t %t.par
+// RUN: llvm-readobj -s -r %t.par | FileCheck %s
+
+// Writing the sections on several threads must produce the same object as
+// writing them one after another, including the relocation sections and the
+// padding between sections of different alignments.
+
+        .section .text.foo,"ax",@progbits
+        .globl foo
+foo:
+        callq bar
+        movq data(%rip), %rax
+        retq
+
+        .section .text.bar,"ax",@progbits
+        .p2align 4
+        .globl bar
+bar:
+        callq foo
+        jmp bar
+
+        .section .data,"aw",@progbits
+        .p2align 3
+data:
+        .quad foo
+        .long bar + 4
+
+        .section .rodata.str1.1,"aMS",@progbits,1
+        .asciz "hello"
+
+        .bss
+        .zero 64
+
+// CHECK:      Name: .rela.data
+// CHECK:      Name: .text.foo
+// CHECK:      Name: .rela.text.foo
+// CHECK:      Name: .text.bar
+// CHECK-NEXT: Type: SHT_PROGBITS
+// CHECK-NEXT: Flags [
+// CHECK-NEXT:   SHF_ALLOC
+// CHECK-NEXT:   SHF_EXECINSTR
+// CHECK-NEXT: ]
+// CHECK-NEXT: Address: 0x0
+// CHECK-NEXT: Offset: 0x60
+
+// CHECK:      Relocations [
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.data {
+// CHECK-NEXT:     0x0 R_X86_64_64 foo 0x0
+// CHECK-NEXT:     0x8 R_X86_64_32 bar 0x4
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.text.foo {
+// CHECK-NEXT:     0x1 R_X86_64_PC32 bar 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:     0x8 R_X86_64_PC32 .data 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.text.bar {
+// CHECK-NEXT:     0x1 R_X86_64_PC32 foo 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:   }
+// CHECK-NEXT: ]
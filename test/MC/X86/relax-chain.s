@@ -0,0 +1,60 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t
+// RUN: llvm-objdump -d %t | FileCheck %s
+// RUN: llvm-objdump -s %t | FileCheck -check-prefix=DATA %s
+
+// Relaxing the second jump moves .Lfar1 out of range of the first one, which
+// has to be relaxed as well, even though it comes before it.
+// CHECK-LABEL: chain:
+// CHECK-NEXT:    0: e9 82 00 00 00 jmp 130
+// CHECK:        7d: e9 83 00 00 00 jmp 131
+// CHECK:        87: cc int3
+// CHECK:       105: cc int3
+chain:
+	jmp	.Lfar1
+	.fill	120, 1, 0x90
+	jmp	.Lfar2
+	.fill	5, 1, 0x90
+.Lfar1:
+	int3
+	.fill	125, 1, 0x90
+.Lfar2:
+	int3
+
+// The alignment absorbs the growth of the jump, so .Lpast doesn't move.
+// CHECK-LABEL: absorbed:
+// CHECK-NEXT:  110: e9 8b 00 00 00 jmp 139
+// CHECK:       1a0: cc int3
+	.p2align	4
+absorbed:
+	jmp	.Lpast
+	.fill	130, 1, 0x90
+	.p2align	4
+.Lpast:
+	int3
+
+// Relaxing the jump makes the first ULEB128 in .rodata one byte longer. That
+// moves the fragments after it, so the second ULEB128 grows as well.
+// CHECK-LABEL: cross:
+// CHECK-NEXT:  1b0: e9 81 00 00 00 jmp 129
+// CHECK:       236: cc int3
+// DATA-LABEL: Contents of section .rodata:
+// DATA-NEXT:  0000 8001aaaa aaaaaaaa aaaaaaaa aaaaaaaa
+// DATA:       0070 aaaaaaaa aaaaaaaa aaaaaaaa aaaaaaaa
+// DATA-NEXT:  0080 8001bb
+	.p2align	4
+cross:
+.Lstart:
+	jmp	.Lafter
+	.fill	123, 1, 0x90
+.Lend:
+	.fill	6, 1, 0x90
+.Lafter:
+	int3
+
+	.section	.rodata,"a",@progbits
+.Ld_start:
+	.uleb128	.Lend-.Lstart
+	.fill	126, 1, 0xaa
+.Ld_end:
+	.uleb128	.Ld_end-.Ld_start
+	.byte	0xbb
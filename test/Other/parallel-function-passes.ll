@@ -0,0 +1,117 @@
+; None of these passes can be run on several threads, since they look at the
+; users of constants and globals. Check that -j runs them one function at a
+; time, with the same result.
+;
+; RUN: opt < %s -instcombine -simplifycfg -S > %t.serial
+; RUN: FileCheck %s < %t.serial
+; RUN: opt < %s -j 4 -instcombine -simplifycfg -S > %t.parallel
+; RUN: diff %t.serial %t.parallel
+; RUN: opt < %s -num-threads=0 -instcombine -simplifycfg -S > %t.parallel
+; RUN: diff %t.serial %t.parallel
+; RUN: opt < %s -sroa -early-cse -S > %t.serial
+; RUN: FileCheck %s -check-prefix=SROA < %t.serial
+; RUN: opt < %s -j 3 -sroa -early-cse -S > %t.parallel
+; RUN: diff %t.serial %t.parallel
+
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:32:64-f32:32:32-f64:32:64-v64:64:64-v128:128:128-a0:0:64-f80:128:128"
+
+@g = global i32 0
+@hello_world = constant [13 x i8] c"hello world\0A\00"
+@h = constant [2 x i8] c"h\00"
+@again_str = constant [7 x i8] c"again\0A\00"
+; CHECK: @str = private unnamed_addr constant [12 x i8] c"hello world\00"
+; CHECK: @str1 = private unnamed_addr constant [6 x i8] c"again\00"
+
+declare i32 @printf(i8*, ...)
+
+define void @hello() {
+; CHECK-LABEL: @hello(
+  %fmt = getelementptr [13 x i8], [13 x i8]* @hello_world, i32 0, i32 0
+  call i32 (i8*, ...)* @printf(i8* %fmt)
+; CHECK-NEXT: call i32 @puts(i8* getelementptr inbounds ([12 x i8]* @str, i32 0, i32 0))
+  ret void
+; CHECK-NEXT: ret void
+}
+
+define void @char() {
+; CHECK-LABEL: @char(
+  %fmt = getelementptr [2 x i8], [2 x i8]* @h, i32 0, i32 0
+  call i32 (i8*, ...)* @printf(i8* %fmt)
+; CHECK-NEXT: call i32 @putchar(i32 104)
+  ret void
+; CHECK-NEXT: ret void
+}
+
+define i32 @fold(i32 %x) {
+; CHECK-LABEL: @fold(
+  %a = add i32 %x, 0
+  %b = mul i32 %a, 1
+  %c = add i32 %b, 7
+  %d = sub i32 %c, 7
+  ret i32 %d
+; CHECK-NEXT: ret i32 %x
+}
+
+define i32 @branch(i1 %c) {
+; CHECK-LABEL: @branch(
+entry:
+  br i1 %c, label %t, label %f
+t:
+  br label %join
+f:
+  br label %join
+join:
+  %p = phi i32 [ 1, %t ], [ 0, %f ]
+  ret i32 %p
+; CHECK-NOT: br
+; CHECK: ret i32
+}
+
+define void @store(i32 %x) {
+; CHECK-LABEL: @store(
+  %a = add i32 %x, 1
+  %b = add i32 %a, -1
+  store i32 %b, i32* @g
+; CHECK-NEXT: store i32 %x, i32* @g
+  ret void
+; CHECK-NEXT: ret void
+}
+
+define i32 @load() {
+; CHECK-LABEL: @load(
+  %v = load i32, i32* @g
+  %w = and i32 %v, %v
+  ret i32 %w
+; CHECK-NEXT: %v = load i32, i32* @g
+; CHECK-NEXT: ret i32 %v
+}
+
+define i32 @alloca(i32 %x) {
+; SROA-LABEL: @alloca(
+  %p = alloca i32
+  store i32 %x, i32* %p
+  %v = load i32, i32* %p
+  %w = load i32, i32* @g
+  %z = load i32, i32* @g
+  %s = add i32 %w, %z
+  %r = add i32 %v, %s
+  ret i32 %r
+; SROA-NEXT: %w = load i32, i32* @g
+; SROA-NEXT: %s = add i32 %w, %w
+; SROA-NEXT: %r = add i32 %x, %s
+; SROA-NEXT: ret i32 %r
+}
+
+define void @again() {
+; CHECK-LABEL: @again(
+  %fmt = getelementptr [7 x i8], [7 x i8]* @again_str, i32 0, i32 0
+  call i32 (i8*, ...)* @printf(i8* %fmt)
+; CHECK-NEXT: call i32 @puts(i8* getelementptr inbounds ([6 x i8]* @str1, i32 0, i32 0))
+  ret void
+; CHECK-NEXT: ret void
+}
+
+; The library call simplifier adds these on whichever thread gets to them
+; first. They come out in the order the functions use them.
+; CHECK: declare i32 @puts(
+; CHECK: declare i32 @putchar(
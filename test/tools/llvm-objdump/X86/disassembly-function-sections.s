@@ -0,0 +1,33 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t
+// RUN: llvm-objdump -d -r %t | FileCheck %s
+// RUN: llvm-objdump -d -r -num-threads=2 %t | FileCheck %s
+
+// Check that with many text sections at the same address, each section is
+// disassembled with only its own symbols and relocations.
+
+// CHECK:      Disassembly of section .text.foo:
+// CHECK-NEXT: foo:
+// CHECK-NEXT:   0: e8 00 00 00 00 callq 0
+// CHECK-NEXT:   {{0*}}1: R_X86_64_PC32 bar-4-P
+// CHECK-NEXT:   5: c3 retq
+// CHECK:      foo_end:
+// CHECK-NEXT:   6: c3 retq
+// CHECK-NEXT: Disassembly of section .text.bar:
+// CHECK-NEXT: bar:
+// CHECK-NEXT:   0: e8 00 00 00 00 callq 0
+// CHECK-NEXT:   {{0*}}1: R_X86_64_PC32 foo-4-P
+// CHECK-NEXT:   5: c3 retq
+
+	.section .text.foo,"ax",@progbits
+	.globl foo
+foo:
+	callq bar
+	retq
+foo_end:
+	retq
+
+	.section .text.bar,"ax",@progbits
+	.globl bar
+bar:
+	callq foo
+	retq
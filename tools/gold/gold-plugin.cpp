@@ -14,12 +14,14 @@
 
 #include "llvm/Config/config.h" // plugin-api.h requires HAVE_STDINT_H
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DiagnosticInfo.h"
@@ -95,6 +97,10 @@ namespace options {
   static std::string extra_library_path;
   static std::string triple;
   static std::string mcpu;
+  // Number of partitions the merged module is split into for code generation.
+  // Each partition is code generated on its own thread and handed to gold as
+  // a separate object file.
+  static unsigned Parallelism = 1;
   // Additional options to pass into the code generator.
   // Note: This array will contain all plugin options which are not claimed
   // as plugin exclusive to pass to the code generator.
@@ -124,6 +130,10 @@ namespace options {
       TheOutputType = OT_SAVE_TEMPS;
     } else if (opt == "disable-output") {
       TheOutputType = OT_DISABLE;
+    } else if (opt.startswith("jobs=")) {
+      StringRef Jobs = opt.substr(strlen("jobs="));
+      if (Jobs.getAsInteger(10, Parallelism) || !Parallelism)
+        message(LDPL_FATAL, "Invalid parallelism level: %s", Jobs.data());
     } else {
       // Save this option to pass to the code generator.
       // ParseCommandLineOptions() expects argv[0] to be program name. Lazily
@@ -763,42 +773,52 @@ static void codegen(Module &M) {
   if (options::TheOutputType == options::OT_SAVE_TEMPS)
     saveBCFile(output_name + ".opt.bc", M);
 
-  legacy::PassManager CodeGenPasses;
-  CodeGenPasses.add(new DataLayoutPass());
-
-  SmallString<128> Filename;
-  int FD;
-  if (options::obj_path.empty()) {
-    std::error_code EC =
-        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
-    if (EC)
-      message(LDPL_FATAL, "Could not create temporary file: %s",
-              EC.message().c_str());
-  } else {
-    Filename = options::obj_path;
-    std::error_code EC =
-        sys::fs::openFileForWrite(Filename.c_str(), FD, sys::fs::F_None);
-    if (EC)
-      message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+  std::list<std::string> Filenames;
+  std::list<raw_fd_ostream> OSs;
+  std::vector<raw_ostream *> OSPtrs;
+  for (unsigned I = 0; I != options::Parallelism; ++I) {
+    SmallString<128> Filename;
+    int FD;
+    if (options::obj_path.empty()) {
+      std::error_code EC =
+          sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+      if (EC)
+        message(LDPL_FATAL, "Could not create temporary file: %s",
+                EC.message().c_str());
+    } else {
+      Filename = options::obj_path;
+      // With several partitions, obj-path is used as a prefix.
+      if (options::Parallelism != 1)
+        Filename += "." + utostr(I);
+      std::error_code EC =
+          sys::fs::openFileForWrite(Filename.c_str(), FD, sys::fs::F_None);
+      if (EC)
+        message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+    }
+    Filenames.push_back(Filename.str());
+    OSs.emplace_back(FD, true);
+    OSPtrs.push_back(&OSs.back());
   }
 
-  {
-    raw_fd_ostream OS(FD, true);
-    formatted_raw_ostream FOS(OS);
+  // With a single partition the module is code generated as is, otherwise
+  // it is split and each part is code generated on a thread of its own.
+  if (!splitCodeGen(M, OSPtrs, options::mcpu, Features.getString(), Options,
+                    ErrMsg, RelocationModel, CodeModel::Default,
+                    CodeGenOpt::Aggressive))
+    message(LDPL_FATAL, "Failed to setup codegen: %s", ErrMsg.c_str());
 
-    if (TM->addPassesToEmitFile(CodeGenPasses, FOS,
-                                TargetMachine::CGFT_ObjectFile))
-      message(LDPL_FATAL, "Failed to setup codegen");
-    CodeGenPasses.run(M);
-  }
+  // Close the object files before handing them to gold.
+  OSs.clear();
 
-  if (add_input_file(Filename.c_str()) != LDPS_OK)
-    message(LDPL_FATAL,
-            "Unable to add .o file to the link. File left behind in: %s",
-            Filename.c_str());
+  for (const std::string &Filename : Filenames) {
+    if (add_input_file(Filename.c_str()) != LDPS_OK)
+      message(LDPL_FATAL,
+              "Unable to add .o file to the link. File left behind in: %s",
+              Filename.c_str());
 
-  if (options::obj_path.empty())
-    Cleanup.push_back(Filename.c_str());
+    if (options::obj_path.empty())
+      Cleanup.push_back(Filename);
+  }
 }
 
 /// gold informs us that all symbols have been read. At this point, we use
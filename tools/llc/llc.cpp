@@ -14,11 +14,13 @@
 //===----------------------------------------------------------------------===//
 
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LLVMContext.h"
@@ -42,6 +44,7 @@
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
+#include <list>
 #include <memory>
 using namespace llvm;
 
@@ -93,6 +96,16 @@ static cl::opt<bool> AsmVerbose("asm-verbose",
                                 cl::desc("Add comments to directives."),
                                 cl::init(true));
 
+static cl::opt<unsigned>
+NumThreads("num-threads", cl::init(1),
+           cl::desc("Number of threads to generate code on; with more than "
+                    "one, the module is split and the output is written to "
+                    "<filename>.0, <filename>.1, ..."));
+
+static cl::alias
+NumThreadsShort("j", cl::desc("Alias for --num-threads"),
+                cl::aliasopt(NumThreads));
+
 static int compileModule(char **, LLVMContext &);
 
 static std::unique_ptr<tool_output_file>
@@ -287,6 +300,58 @@ static int compileModule(char **argv, LLVMContext &Context) {
   if (GenerateSoftFloatCalls)
     FloatABIForCalls = FloatABI::Soft;
 
+  // The codegen passes can't be run on several functions at once, so spread
+  // the work by splitting the module instead, and generate code for each part
+  // on a thread of its own.
+  if (NumThreads == 0) {
+    errs() << argv[0] << ": -num-threads must be at least 1\n";
+    return 1;
+  }
+  unsigned Threads = NumThreads;
+  if (Threads > 1) {
+    if (OutputFilename.empty() || OutputFilename == "-") {
+      errs() << argv[0] << ": -num-threads must be specified together with "
+             << "-o\n";
+      return 1;
+    }
+    if (!StartAfter.empty() || !StopAfter.empty()) {
+      errs() << argv[0] << ": -start-after and -stop-after can't be used "
+             << "with -num-threads\n";
+      return 1;
+    }
+
+    std::list<tool_output_file> OSs;
+    std::vector<raw_ostream *> OSPtrs;
+    for (unsigned I = 0; I != Threads; ++I) {
+      std::string PartFilename = OutputFilename + "." + utostr(I);
+      std::error_code EC;
+      OSs.emplace_back(PartFilename, EC,
+                       FileType == TargetMachine::CGFT_ObjectFile
+                           ? sys::fs::F_None
+                           : sys::fs::F_Text);
+      if (EC) {
+        errs() << argv[0] << ": error opening the file '" << PartFilename
+               << "': " << EC.message() << "\n";
+        return 1;
+      }
+      OSPtrs.push_back(&OSs.back().os());
+    }
+
+    cl::PrintOptionValues();
+
+    M->setTargetTriple(TheTriple.getTriple());
+    std::string ErrMsg;
+    if (!splitCodeGen(*M, OSPtrs, MCPU, FeaturesStr, Options, ErrMsg,
+                      RelocModel, CMModel, OLvl, FileType)) {
+      errs() << argv[0] << ": " << ErrMsg << "\n";
+      return 1;
+    }
+
+    for (tool_output_file &OS : OSs)
+      OS.keep();
+    return 0;
+  }
+
   // Figure out where we are going to send the output.
   std::unique_ptr<tool_output_file> Out =
       GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]);
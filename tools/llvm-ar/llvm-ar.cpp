@@ -12,6 +12,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -19,6 +21,7 @@
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Errc.h"
+#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/LineIterator.h"
@@ -27,7 +30,6 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
-#include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdlib>
@@ -44,16 +46,9 @@ using namespace llvm;
 // The name this program was invoked as.
 static StringRef ToolName;
 
-static const char *TemporaryOutput;
-static int TmpArchiveFD = -1;
-
 // Show the error message and exit.
 LLVM_ATTRIBUTE_NORETURN static void fail(Twine Error) {
   outs() << ToolName << ": " << Error << ".\n";
-  if (TmpArchiveFD != -1)
-    close(TmpArchiveFD);
-  if (TemporaryOutput)
-    sys::fs::remove(TemporaryOutput);
   exit(1);
 }
 
@@ -84,8 +79,8 @@ static cl::extrahelp MoreHelp(
   "  d[NsS]       - delete file(s) from the archive\n"
   "  m[abiSs]     - move file(s) in the archive\n"
   "  p[kN]        - print file(s) found in the archive\n"
-  "  q[ufsS]      - quick append file(s) to the archive\n"
-  "  r[abfiuRsS]  - replace or insert file(s) into the archive\n"
+  "  q[ufsST]     - quick append file(s) to the archive\n"
+  "  r[abfiuRsST] - replace or insert file(s) into the archive\n"
   "  t            - display contents of archive\n"
   "  x[No]        - extract file(s) from the archive\n"
   "\nMODIFIERS (operation specific):\n"
@@ -95,6 +90,7 @@ static cl::extrahelp MoreHelp(
   "  [o] - preserve original dates\n"
   "  [s] - create an archive index (cf. ranlib)\n"
   "  [S] - do not build a symbol table\n"
+  "  [T] - create a thin archive\n"
   "  [u] - update only files newer than archive contents\n"
   "\nMODIFIERS (generic):\n"
   "  [c] - do not warn if the library had to be created\n"
@@ -122,6 +118,7 @@ static bool OriginalDates = false; ///< 'o' modifier
 static bool OnlyUpdate = false;    ///< 'u' modifier
 static bool Verbose = false;       ///< 'v' modifier
 static bool Symtab = true;         ///< 's' modifier
+static bool Thin = false;          ///< 'T' modifier
 
 // Relative Positional Argument (for insert/move). This variable holds
 // the name of the archive member to which the 'a', 'b' or 'i' modifier
@@ -222,6 +219,7 @@ static ArchiveOperation parseCommandLine() {
       Symtab = false;
       break;
     case 'u': OnlyUpdate = true; break;
+    case 'T': Thin = true; break;
     case 'v': Verbose = true; break;
     case 'a':
       getRelPos();
@@ -274,6 +272,9 @@ static ArchiveOperation parseCommandLine() {
     show_help("The 'o' modifier is only applicable to the 'x' operation");
   if (OnlyUpdate && Operation != ReplaceOrInsert)
     show_help("The 'u' modifier is only applicable to the 'r' operation");
+  if (Thin && Operation != QuickAppend && Operation != ReplaceOrInsert)
+    show_help("The 'T' modifier is only applicable to the 'q' and 'r' "
+              "operations");
 
   // Return the parsed operation to the caller
   return Operation;
@@ -285,7 +286,9 @@ static void doPrint(StringRef Name, object::Archive::child_iterator I) {
   if (Verbose)
     outs() << "Printing " << Name << "\n";
 
-  StringRef Data = I->getBuffer();
+  ErrorOr<MemoryBufferRef> DataOrErr = I->getMemoryBufferRef();
+  failIfError(DataOrErr.getError(), Name);
+  StringRef Data = DataOrErr->getBuffer();
   outs().write(Data.data(), Data.size());
 }
 
@@ -341,7 +344,9 @@ static void doExtract(StringRef Name, object::Archive::child_iterator I) {
     raw_fd_ostream file(FD, false);
 
     // Get the data and its length
-    StringRef Data = I->getBuffer();
+    ErrorOr<MemoryBufferRef> DataOrErr = I->getMemoryBufferRef();
+    failIfError(DataOrErr.getError(), Name);
+    StringRef Data = DataOrErr->getBuffer();
 
     // Write the data.
     file.write(Data.data(), Data.size());
@@ -377,6 +382,10 @@ static bool shouldCreateArchive(ArchiveOperation Op) {
 
 static void performReadOperation(ArchiveOperation Operation,
                                  object::Archive *OldArchive) {
+  // The members of a thin archive already live in the file system.
+  if (Operation == Extract && OldArchive->isThin())
+    fail("extracting from a thin archive is not supported");
+
   for (object::Archive::child_iterator I = OldArchive->child_begin(),
                                        E = OldArchive->child_end();
        I != E; ++I) {
@@ -478,6 +487,67 @@ void addMember(std::vector<NewArchiveIterator> &Members, T I, StringRef Name,
     Members[Pos] = NI;
 }
 
+// Returns the path of To relative to the directory From. Both are normalized
+// lexically, the same way GNU ar does for thin archives.
+static std::string computeRelativePath(StringRef From, StringRef To) {
+  SmallString<128> FromAbs = From;
+  SmallString<128> ToAbs = To;
+  failIfError(sys::fs::make_absolute(FromAbs), From);
+  failIfError(sys::fs::make_absolute(ToAbs), To);
+
+  auto Normalize = [](StringRef Path, SmallVectorImpl<StringRef> &Components) {
+    for (sys::path::const_iterator I = sys::path::begin(Path),
+                                   E = sys::path::end(Path);
+         I != E; ++I) {
+      if (*I == ".")
+        continue;
+      if (*I == "..") {
+        // Never pop the root.
+        if (Components.size() > 1)
+          Components.pop_back();
+        continue;
+      }
+      Components.push_back(*I);
+    }
+  };
+  SmallVector<StringRef, 16> FromComponents;
+  SmallVector<StringRef, 16> ToComponents;
+  Normalize(FromAbs, FromComponents);
+  Normalize(ToAbs, ToComponents);
+
+  unsigned Common = 0;
+  while (Common < FromComponents.size() && Common < ToComponents.size() &&
+         FromComponents[Common] == ToComponents[Common])
+    ++Common;
+  // Paths on different drives have no relative path between them.
+  if (Common == 0)
+    return ToAbs.str();
+
+  SmallString<128> Result;
+  for (unsigned I = Common, E = FromComponents.size(); I != E; ++I)
+    sys::path::append(Result, "..");
+  for (unsigned I = Common, E = ToComponents.size(); I != E; ++I)
+    sys::path::append(Result, ToComponents[I]);
+  return Result.str();
+}
+
+// Returns the name the file at Path has as an archive member. Regular
+// archives only keep the file name; thin archives refer to their members by
+// their path relative to the directory of the archive.
+static StringRef getMemberName(StringRef Path) {
+  if (!Thin || Path.empty())
+    return sys::path::filename(Path);
+
+  // This is called for every pair of old and new members, so only compute
+  // each relative path once.
+  static StringMap<std::string> ThinNames;
+  auto Entry = ThinNames.insert(std::make_pair(Path, std::string()));
+  if (Entry.second)
+    Entry.first->second =
+        computeRelativePath(sys::path::parent_path(ArchiveName), Path);
+  return Entry.first->second;
+}
+
 enum InsertAction {
   IA_AddOldMember,
   IA_AddNewMeber,
@@ -495,7 +565,7 @@ static InsertAction computeInsertAction(ArchiveOperation Operation,
 
   auto MI =
       std::find_if(Members.begin(), Members.end(), [Name](StringRef Path) {
-        return Name == sys::path::filename(Path);
+        return Name == getMemberName(Path);
       });
 
   if (MI == Members.end())
@@ -510,7 +580,7 @@ static InsertAction computeInsertAction(ArchiveOperation Operation,
     return IA_MoveOldMember;
 
   if (Operation == ReplaceOrInsert) {
-    StringRef PosName = sys::path::filename(RelPos);
+    StringRef PosName = getMemberName(RelPos);
     if (!OnlyUpdate) {
       if (PosName.empty())
         return IA_AddNewMeber;
@@ -542,7 +612,7 @@ computeNewArchiveMembers(ArchiveOperation Operation,
   std::vector<NewArchiveIterator> Ret;
   std::vector<NewArchiveIterator> Moved;
   int InsertPos = -1;
-  StringRef PosName = sys::path::filename(RelPos);
+  StringRef PosName = getMemberName(RelPos);
   if (OldArchive) {
     for (auto &Child : OldArchive->children()) {
       int Pos = Ret.size();
@@ -596,8 +666,7 @@ computeNewArchiveMembers(ArchiveOperation Operation,
   Ret.insert(Ret.begin() + InsertPos, Members.size(), NewArchiveIterator());
   int Pos = InsertPos;
   for (auto &Member : Members) {
-    StringRef Name = sys::path::filename(Member);
-    addMember(Ret, Member, Name, Pos);
+    addMember(Ret, Member, getMemberName(Member), Pos);
     ++Pos;
   }
 
@@ -605,31 +674,30 @@ computeNewArchiveMembers(ArchiveOperation Operation,
 }
 
 template <typename T>
-static void printWithSpacePadding(raw_fd_ostream &OS, T Data, unsigned Size,
-				  bool MayTruncate = false) {
-  uint64_t OldPos = OS.tell();
-  OS << Data;
-  unsigned SizeSoFar = OS.tell() - OldPos;
-  if (Size > SizeSoFar) {
-    unsigned Remaining = Size - SizeSoFar;
-    for (unsigned I = 0; I < Remaining; ++I)
-      OS << ' ';
-  } else if (Size < SizeSoFar) {
+static void printWithSpacePadding(raw_ostream &OS, T Data, unsigned Size,
+                                  bool MayTruncate = false) {
+  SmallString<32> Buf;
+  raw_svector_ostream BufOS(Buf);
+  BufOS << Data;
+  StringRef Str = BufOS.str();
+  if (Str.size() > Size) {
     assert(MayTruncate && "Data doesn't fit in Size");
     // Some of the data this is used for (like UID) can be larger than the
     // space available in the archive format. Truncate in that case.
-    OS.seek(OldPos + Size);
+    Str = Str.substr(0, Size);
   }
+  OS << Str;
+  OS.indent(Size - Str.size());
 }
 
-static void print32BE(raw_fd_ostream &Out, unsigned Val) {
+static void print32BE(raw_ostream &Out, unsigned Val) {
   for (int I = 3; I >= 0; --I) {
     char V = (Val >> (8 * I)) & 0xff;
     Out << V;
   }
 }
 
-static void printRestOfMemberHeader(raw_fd_ostream &Out,
+static void printRestOfMemberHeader(raw_ostream &Out,
                                     const sys::TimeValue &ModTime, unsigned UID,
                                     unsigned GID, unsigned Perms,
                                     unsigned Size) {
@@ -641,14 +709,14 @@ static void printRestOfMemberHeader(raw_fd_ostream &Out,
   Out << "`\n";
 }
 
-static void printMemberHeader(raw_fd_ostream &Out, StringRef Name,
+static void printMemberHeader(raw_ostream &Out, StringRef Name,
                               const sys::TimeValue &ModTime, unsigned UID,
                               unsigned GID, unsigned Perms, unsigned Size) {
   printWithSpacePadding(Out, Twine(Name) + "/", 16);
   printRestOfMemberHeader(Out, ModTime, UID, GID, Perms, Size);
 }
 
-static void printMemberHeader(raw_fd_ostream &Out, unsigned NameOffset,
+static void printMemberHeader(raw_ostream &Out, unsigned NameOffset,
                               const sys::TimeValue &ModTime, unsigned UID,
                               unsigned GID, unsigned Perms, unsigned Size) {
   Out << '/';
@@ -656,61 +724,93 @@ static void printMemberHeader(raw_fd_ostream &Out, unsigned NameOffset,
   printRestOfMemberHeader(Out, ModTime, UID, GID, Perms, Size);
 }
 
-static void writeStringTable(raw_fd_ostream &Out,
-                             ArrayRef<NewArchiveIterator> Members,
-                             std::vector<unsigned> &StringMapIndexes) {
-  unsigned StartOffset = 0;
-  for (ArrayRef<NewArchiveIterator>::iterator I = Members.begin(),
-                                              E = Members.end();
-       I != E; ++I) {
-    StringRef Name = I->getName();
-    if (Name.size() < 16)
+static const unsigned MemberHeaderSize = 60;
+
+// Computes the contents of the "//" member holding the names that don't fit
+// in a member header, and the offset of each of those names in it. Thin
+// archives keep all their member names there.
+static void computeStringTable(ArrayRef<NewArchiveIterator> Members,
+                               std::string &StringTable,
+                               std::vector<unsigned> &StringMapIndexes) {
+  for (const NewArchiveIterator &Member : Members) {
+    StringRef Name = Member.getName();
+    if (!Thin && Name.size() < 16)
       continue;
-    if (StartOffset == 0) {
-      printWithSpacePadding(Out, "//", 58);
-      Out << "`\n";
-      StartOffset = Out.tell();
-    }
-    StringMapIndexes.push_back(Out.tell() - StartOffset);
-    Out << Name << "/\n";
+    StringMapIndexes.push_back(StringTable.size());
+    StringTable += Name;
+    StringTable += "/\n";
   }
-  if (StartOffset == 0)
-    return;
-  if (Out.tell() % 2)
-    Out << '\n';
-  int Pos = Out.tell();
-  Out.seek(StartOffset - 12);
-  printWithSpacePadding(Out, Pos - StartOffset, 10);
-  Out.seek(Pos);
+  if (StringTable.size() % 2)
+    StringTable += '\n';
 }
 
-// Returns the offset of the first reference to a member offset.
-static unsigned writeSymbolTable(raw_fd_ostream &Out,
-                                 ArrayRef<NewArchiveIterator> Members,
-                                 ArrayRef<MemoryBufferRef> Buffers,
-                                 std::vector<unsigned> &MemberOffsetRefs) {
-  unsigned StartOffset = 0;
-  unsigned MemberNum = 0;
-  std::string NameBuf;
-  raw_string_ostream NameOS(NameBuf);
-  unsigned NumSyms = 0;
+// Collects the names of the symbols exported by each member into SymNames and
+// the index of the defining member of each symbol into MemberOffsetRefs.
+// Members carried over from OldArchive are copied with their header and
+// contents unchanged, so they take their symbols from its existing symbol
+// table and only new and replaced members have to be parsed. A symbol table
+// that can't be read is ignored. Returns false if no member is an object file.
+static bool computeSymbolTable(object::Archive *OldArchive,
+                               ArrayRef<NewArchiveIterator> Members,
+                               ArrayRef<MemoryBufferRef> Buffers,
+                               std::string &SymNames,
+                               std::vector<unsigned> &MemberOffsetRefs) {
+  // Map the offset of each old member to the symbols it defines.
+  DenseMap<uint64_t, std::vector<StringRef>> OldSymbols;
+  if (OldArchive && OldArchive->hasSymbolTable()) {
+    for (object::Archive::symbol_iterator I = OldArchive->symbol_begin(),
+                                          E = OldArchive->symbol_end();
+         I != E; ++I) {
+      ErrorOr<object::Archive::child_iterator> MemberOrErr = I->getMember();
+      if (MemberOrErr.getError()) {
+        // Rebuild the whole table from the members.
+        OldSymbols.clear();
+        break;
+      }
+      OldSymbols[(*MemberOrErr)->getChildOffset()].push_back(I->getName());
+    }
+  }
+
+  bool HasObject = false;
+  raw_string_ostream NameOS(SymNames);
   LLVMContext &Context = getGlobalContext();
-  for (ArrayRef<NewArchiveIterator>::iterator I = Members.begin(),
-                                              E = Members.end();
-       I != E; ++I, ++MemberNum) {
+  for (unsigned MemberNum = 0, N = Members.size(); MemberNum < N;
+       ++MemberNum) {
     MemoryBufferRef MemberBuffer = Buffers[MemberNum];
+
+    object::Archive::child_iterator OldMember;
+    if (!Members[MemberNum].isNewMember())
+      OldMember = Members[MemberNum].getOld();
+
+    // The members of a thin archive are only read when they are needed.
+    if (!MemberBuffer.getBufferStart()) {
+      ErrorOr<MemoryBufferRef> MemberBufferOrErr =
+          OldMember->getMemoryBufferRef();
+      failIfError(MemberBufferOrErr.getError());
+      MemberBuffer = MemberBufferOrErr.get();
+    }
+
+    // Members that came from a different archive (see the MRI "addlib"
+    // command) are not described by the old symbol table.
+    if (OldArchive && OldMember->getParent() == OldArchive) {
+      auto I = OldSymbols.find(OldMember->getChildOffset());
+      if (I != OldSymbols.end()) {
+        HasObject = true;
+        for (StringRef Name : I->second) {
+          NameOS << Name << '\0';
+          MemberOffsetRefs.push_back(MemberNum);
+        }
+        continue;
+      }
+    }
+
     ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
         object::SymbolicFile::createSymbolicFile(
             MemberBuffer, sys::fs::file_magic::unknown, &Context);
     if (!ObjOrErr)
       continue;  // FIXME: check only for "not an object file" errors.
     object::SymbolicFile &Obj = *ObjOrErr.get();
-
-    if (!StartOffset) {
-      printMemberHeader(Out, "", sys::TimeValue::now(), 0, 0, 0, 0);
-      StartOffset = Out.tell();
-      print32BE(Out, 0);
-    }
+    HasObject = true;
 
     for (const object::BasicSymbolRef &S : Obj.symbols()) {
       uint32_t Symflags = S.getFlags();
@@ -722,42 +822,16 @@ static unsigned writeSymbolTable(raw_fd_ostream &Out,
         continue;
       failIfError(S.printName(NameOS));
       NameOS << '\0';
-      ++NumSyms;
       MemberOffsetRefs.push_back(MemberNum);
-      print32BE(Out, 0);
     }
   }
-  Out << NameOS.str();
-
-  if (StartOffset == 0)
-    return 0;
-
-  if (Out.tell() % 2)
-    Out << '\0';
-
-  unsigned Pos = Out.tell();
-  Out.seek(StartOffset - 12);
-  printWithSpacePadding(Out, Pos - StartOffset, 10);
-  Out.seek(StartOffset);
-  print32BE(Out, NumSyms);
-  Out.seek(Pos);
-  return StartOffset + 4;
+  NameOS.flush();
+  return HasObject;
 }
 
 static void
 performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
                       std::vector<NewArchiveIterator> &NewMembers) {
-  SmallString<128> TmpArchive;
-  failIfError(sys::fs::createUniqueFile(ArchiveName + ".temp-archive-%%%%%%%.a",
-                                        TmpArchiveFD, TmpArchive));
-
-  TemporaryOutput = TmpArchive.c_str();
-  tool_output_file Output(TemporaryOutput, TmpArchiveFD);
-  raw_fd_ostream &Out = Output.os();
-  Out << "!<arch>\n";
-
-  std::vector<unsigned> MemberOffsetRefs;
-
   std::vector<std::unique_ptr<MemoryBuffer>> Buffers;
   std::vector<MemoryBufferRef> Members;
   std::vector<sys::fs::file_status> NewMemberStatus;
@@ -778,7 +852,7 @@ performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
         fail("Could not close file");
       Buffers.push_back(std::move(MemberBufferOrErr.get()));
       MemberRef = Buffers.back()->getMemBufferRef();
-    } else {
+    } else if (!Thin) {
       object::Archive::child_iterator OldMember = Member.getOld();
       ErrorOr<MemoryBufferRef> MemberBufferOrErr =
           OldMember->getMemoryBufferRef();
@@ -788,39 +862,88 @@ performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
     Members.push_back(MemberRef);
   }
 
-  unsigned MemberReferenceOffset = 0;
-  if (Symtab) {
-    MemberReferenceOffset =
-        writeSymbolTable(Out, NewMembers, Members, MemberOffsetRefs);
-  }
+  std::string SymNames;
+  std::vector<unsigned> MemberOffsetRefs;
+  bool HasSymbolTable =
+      Symtab && computeSymbolTable(OldArchive, NewMembers, Members, SymNames,
+                                   MemberOffsetRefs);
 
+  std::string StringTable;
   std::vector<unsigned> StringMapIndexes;
-  writeStringTable(Out, NewMembers, StringMapIndexes);
+  computeStringTable(NewMembers, StringTable, StringMapIndexes);
+
+  // Lay out the archive before writing anything, so that the symbol table can
+  // be emitted with the final member offsets and the whole file can be written
+  // into a single FileOutputBuffer.
+  unsigned SymbolTableSize = 0;
+  if (HasSymbolTable) {
+    SymbolTableSize = 4 + 4 * MemberOffsetRefs.size() + SymNames.size();
+    SymbolTableSize += SymbolTableSize % 2;
+  }
+  uint64_t Pos = 8;
+  if (HasSymbolTable)
+    Pos += MemberHeaderSize + SymbolTableSize;
+  if (!StringTable.empty())
+    Pos += MemberHeaderSize + StringTable.size();
+  const uint64_t HeadSize = Pos;
+
+  // The members of a thin archive are only headers.
+  std::vector<unsigned> MemberOffset;
+  for (MemoryBufferRef File : Members) {
+    MemberOffset.push_back(Pos);
+    Pos += MemberHeaderSize;
+    if (!Thin)
+      Pos += File.getBufferSize() + File.getBufferSize() % 2;
+  }
+  const uint64_t ArchiveSize = Pos;
+
+  std::string Head;
+  raw_string_ostream Out(Head);
+  Out << (Thin ? "!<thin>\n" : "!<arch>\n");
+  if (HasSymbolTable) {
+    printMemberHeader(Out, "", sys::TimeValue::now(), 0, 0, 0, SymbolTableSize);
+    print32BE(Out, MemberOffsetRefs.size());
+    for (unsigned MemberNum : MemberOffsetRefs)
+      print32BE(Out, MemberOffset[MemberNum]);
+    Out << SymNames;
+    if (SymNames.size() % 2)
+      Out << '\0';
+  }
+  if (!StringTable.empty()) {
+    printWithSpacePadding(Out, "//", 48);
+    printWithSpacePadding(Out, StringTable.size(), 10);
+    Out << "`\n" << StringTable;
+  }
+  Out.flush();
+  assert(Head.size() == HeadSize && "Archive layout mismatch");
+
+  std::unique_ptr<FileOutputBuffer> Output;
+  failIfError(FileOutputBuffer::create(ArchiveName, ArchiveSize, Output),
+              ArchiveName);
+  uint8_t *Buf = Output->getBufferStart();
+  memcpy(Buf, Head.data(), HeadSize);
 
   unsigned MemberNum = 0;
   unsigned LongNameMemberNum = 0;
   unsigned NewMemberNum = 0;
-  std::vector<unsigned> MemberOffset;
   for (std::vector<NewArchiveIterator>::iterator I = NewMembers.begin(),
                                                  E = NewMembers.end();
        I != E; ++I, ++MemberNum) {
-
-    unsigned Pos = Out.tell();
-    MemberOffset.push_back(Pos);
+    SmallString<MemberHeaderSize> Header;
+    raw_svector_ostream HeaderOS(Header);
 
     MemoryBufferRef File = Members[MemberNum];
     if (I->isNewMember()) {
-      StringRef FileName = I->getNew();
       const sys::fs::file_status &Status = NewMemberStatus[NewMemberNum];
       NewMemberNum++;
 
-      StringRef Name = sys::path::filename(FileName);
-      if (Name.size() < 16)
-        printMemberHeader(Out, Name, Status.getLastModificationTime(),
+      StringRef Name = I->getName();
+      if (!Thin && Name.size() < 16)
+        printMemberHeader(HeaderOS, Name, Status.getLastModificationTime(),
                           Status.getUser(), Status.getGroup(),
                           Status.permissions(), Status.getSize());
       else
-        printMemberHeader(Out, StringMapIndexes[LongNameMemberNum++],
+        printMemberHeader(HeaderOS, StringMapIndexes[LongNameMemberNum++],
                           Status.getLastModificationTime(), Status.getUser(),
                           Status.getGroup(), Status.permissions(),
                           Status.getSize());
@@ -828,38 +951,45 @@ performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
       object::Archive::child_iterator OldMember = I->getOld();
       StringRef Name = I->getName();
 
-      if (Name.size() < 16)
-        printMemberHeader(Out, Name, OldMember->getLastModified(),
+      if (!Thin && Name.size() < 16)
+        printMemberHeader(HeaderOS, Name, OldMember->getLastModified(),
                           OldMember->getUID(), OldMember->getGID(),
                           OldMember->getAccessMode(), OldMember->getSize());
       else
-        printMemberHeader(Out, StringMapIndexes[LongNameMemberNum++],
+        printMemberHeader(HeaderOS, StringMapIndexes[LongNameMemberNum++],
                           OldMember->getLastModified(), OldMember->getUID(),
                           OldMember->getGID(), OldMember->getAccessMode(),
                           OldMember->getSize());
     }
-
-    Out << File.getBuffer();
-
-    if (Out.tell() % 2)
-      Out << '\n';
-  }
-
-  if (MemberReferenceOffset) {
-    Out.seek(MemberReferenceOffset);
-    for (unsigned MemberNum : MemberOffsetRefs)
-      print32BE(Out, MemberOffset[MemberNum]);
+    StringRef HeaderStr = HeaderOS.str();
+    assert(HeaderStr.size() == MemberHeaderSize);
+
+    // Members carried over from the old archive are copied straight out of
+    // its mapping; nothing about them is re-read or re-parsed.
+    uint8_t *MemberStart = Buf + MemberOffset[MemberNum];
+    memcpy(MemberStart, HeaderStr.data(), MemberHeaderSize);
+    if (Thin)
+      continue;
+    memcpy(MemberStart + MemberHeaderSize, File.getBufferStart(),
+           File.getBufferSize());
+    if (File.getBufferSize() % 2)
+      MemberStart[MemberHeaderSize + File.getBufferSize()] = '\n';
   }
 
-  Output.keep();
-  Out.close();
-  sys::fs::rename(TemporaryOutput, ArchiveName);
-  TemporaryOutput = nullptr;
+  failIfError(Output->commit(), ArchiveName);
 }
 
 static void
 performWriteOperation(ArchiveOperation Operation, object::Archive *OldArchive,
                       std::vector<NewArchiveIterator> *NewMembersP) {
+  if (OldArchive) {
+    // An existing archive keeps its kind.
+    if (OldArchive->isThin())
+      Thin = true;
+    else if (Thin && OldArchive->child_begin() != OldArchive->child_end())
+      fail("cannot convert a regular archive to a thin archive");
+  }
+
   if (NewMembersP) {
     performWriteOperation(Operation, OldArchive, *NewMembersP);
     return;
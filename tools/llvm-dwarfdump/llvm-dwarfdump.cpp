@@ -14,6 +14,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/DebugInfo/DWARF/DIContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/RelocVisitor.h"
 #include "llvm/Support/CommandLine.h"
@@ -23,6 +24,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
@@ -37,6 +39,10 @@ static cl::list<std::string>
 InputFilenames(cl::Positional, cl::desc("<input object files>"),
                cl::ZeroOrMore);
 
+static cl::opt<bool>
+Preload("preload", cl::init(false),
+        cl::desc("Parse the compile units on several threads before dumping"));
+
 static cl::opt<DIDumpType>
 DumpType("debug-dump", cl::init(DIDT_All),
   cl::desc("Dump of debug sections:"),
@@ -87,6 +93,12 @@ static void DumpInput(StringRef Filename) {
   ObjectFile &Obj = *ObjOrErr.get();
 
   std::unique_ptr<DIContext> DICtx(DIContext::getDWARFContext(Obj));
+  if (Preload) {
+    if (auto *DWARFCtx = dyn_cast<DWARFContext>(DICtx.get())) {
+      ThreadPool Pool;
+      DWARFCtx->preloadUnits(Pool);
+    }
+  }
 
   outs() << Filename
          << ":\tfile format " << Obj.getFileFormatName() << "\n\n";
@@ -23,19 +23,38 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include <algorithm>
 #include <memory>
+#include <mutex>
 using namespace llvm;
 
 static cl::list<std::string>
 InputFilenames(cl::Positional, cl::OneOrMore,
                cl::desc("<input bitcode files>"));
 
+static cl::opt<bool>
+OnlyNeeded("only-needed",
+           cl::desc("Link in only what the first input needs from the "
+                    "other inputs"));
+
+static cl::opt<unsigned>
+NumThreads("num-threads", cl::init(1),
+           cl::desc("Number of threads to link with: the inputs are split "
+                    "into that many runs, which are linked in parallel and "
+                    "then merged pairwise (0 = one per hardware thread)"));
+
+static cl::alias
+NumThreadsShort("j", cl::desc("Alias for --num-threads"),
+                cl::aliasopt(NumThreads));
+
 static cl::opt<std::string>
 OutputFilename("o", cl::desc("Override output filename"), cl::init("-"),
                cl::value_desc("filename"));
@@ -57,29 +76,44 @@ static cl::opt<bool>
 SuppressWarnings("suppress-warnings", cl::desc("Suppress all linking warnings"),
                  cl::init(false));
 
+// Diagnostics and verbose output may come from several linking threads.
+static std::mutex OutputLock;
+
 // Read the specified bitcode file in and return it. This routine searches the
 // link path for the specified file to try to find it...
 //
 static std::unique_ptr<Module>
 loadFile(const char *argv0, const std::string &FN, LLVMContext &Context) {
   SMDiagnostic Err;
-  if (Verbose) errs() << "Loading '" << FN << "'\n";
-  std::unique_ptr<Module> Result = getLazyIRFileModule(FN, Err, Context);
-  if (!Result)
+  if (Verbose) {
+    std::lock_guard<std::mutex> Guard(OutputLock);
+    errs() << "Loading '" << FN << "'\n";
+  }
+  std::unique_ptr<Module> Result =
+      getLazyIRFileModule(FN, Err, Context, /*ShouldLazyLoadMetadata=*/true);
+  if (!Result) {
+    std::lock_guard<std::mutex> Guard(OutputLock);
     Err.print(argv0, errs());
+    errs() << argv0 << ": error loading file '" << FN << "'\n";
+  } else if (Verbose) {
+    std::lock_guard<std::mutex> Guard(OutputLock);
+    errs() << "Linking in '" << FN << "'\n";
+  }
 
   return Result;
 }
 
 static void diagnosticHandler(const DiagnosticInfo &DI) {
   unsigned Severity = DI.getSeverity();
+  if (Severity == DS_Warning && SuppressWarnings)
+    return;
+
+  std::lock_guard<std::mutex> Guard(OutputLock);
   switch (Severity) {
   case DS_Error:
     errs() << "ERROR: ";
     break;
   case DS_Warning:
-    if (SuppressWarnings)
-      return;
     errs() << "WARNING: ";
     break;
   case DS_Remark:
@@ -92,6 +126,102 @@ static void diagnosticHandler(const DiagnosticInfo &DI) {
   errs() << '\n';
 }
 
+/// Lazily read back a module that linkToBitcode() wrote to \p Bitcode. The
+/// buffer must outlive the module.
+static std::unique_ptr<Module> loadBitcode(const SmallVectorImpl<char> &Bitcode,
+                                           LLVMContext &Context) {
+  ErrorOr<Module *> MOrErr = getLazyBitcodeModule(
+      MemoryBuffer::getMemBuffer(StringRef(Bitcode.data(), Bitcode.size()),
+                                 "llvm-link", false),
+      Context);
+  if (!MOrErr)
+    report_fatal_error("Failed to read back a partially linked module: " +
+                       MOrErr.getError().message());
+  return std::unique_ptr<Module>(MOrErr.get());
+}
+
+/// Link the \p N modules that \p Load returns, in order, into a fresh module
+/// in a context of its own, and write the result to \p Bitcode. An
+/// LLVMContext is not thread safe, so this is how a partial link is moved from
+/// the thread that made it to the one that merges it.
+static bool linkToBitcode(
+    unsigned N,
+    function_ref<std::unique_ptr<Module>(unsigned, LLVMContext &)> Load,
+    SmallVectorImpl<char> &Bitcode) {
+  LLVMContext Context;
+  Module Composite("llvm-link", Context);
+  Linker L(&Composite, diagnosticHandler);
+  for (unsigned I = 0; I != N; ++I) {
+    std::unique_ptr<Module> M = Load(I, Context);
+    if (!M || L.linkInModule(M.get()))
+      return false;
+  }
+
+  raw_svector_ostream OS(Bitcode);
+  WriteBitcodeToFile(&Composite, OS);
+  OS.flush();
+  return true;
+}
+
+/// Link the inputs on \p Threads threads and return at most two partial
+/// links, in input order, for the caller to merge. The inputs are split into
+/// one contiguous run per thread, and the runs are then merged pairwise,
+/// neighbour with neighbour, halving their number at each step. Since the
+/// order of the inputs is preserved, symbols resolve as if the inputs were
+/// linked one by one, but the partial links rename clashing local symbols and
+/// struct types and order definitions in their own way. Returns false if any
+/// input fails to load or link.
+static bool linkInParallel(const char *argv0, unsigned Threads,
+                           std::vector<SmallVector<char, 0>> &Bitcodes) {
+  unsigned NumInputs = InputFilenames.size();
+  // The per-task results are only written by their own task.
+  std::unique_ptr<bool[]> Succeeded(new bool[Threads]);
+  ThreadPool Pool(Threads);
+
+  Bitcodes.resize(Threads);
+  for (unsigned I = 0; I != Threads; ++I) {
+    unsigned Begin = uint64_t(NumInputs) * I / Threads;
+    unsigned End = uint64_t(NumInputs) * (I + 1) / Threads;
+    Pool.async([&, I, Begin, End] {
+      Succeeded[I] = linkToBitcode(
+          End - Begin,
+          [&](unsigned J, LLVMContext &Context) {
+            return loadFile(argv0, InputFilenames[Begin + J], Context);
+          },
+          Bitcodes[I]);
+    });
+  }
+  Pool.wait();
+  if (std::find(&Succeeded[0], &Succeeded[Threads], false) !=
+      &Succeeded[Threads])
+    return false;
+
+  // The last two partial links are merged by the caller, straight into the
+  // final module, which saves a round trip through bitcode.
+  while (Bitcodes.size() > 2) {
+    unsigned Live = Bitcodes.size();
+    std::vector<SmallVector<char, 0>> Merged(Live / 2);
+    for (unsigned I = 0; I != Live / 2; ++I)
+      Pool.async([&, I] {
+        Succeeded[I] = linkToBitcode(
+            2,
+            [&](unsigned J, LLVMContext &Context) {
+              return loadBitcode(Bitcodes[2 * I + J], Context);
+            },
+            Merged[I]);
+      });
+    Pool.wait();
+    if (std::find(&Succeeded[0], &Succeeded[Live / 2], false) !=
+        &Succeeded[Live / 2])
+      return false;
+
+    if (Live % 2)
+      Merged.push_back(std::move(Bitcodes.back()));
+    Bitcodes = std::move(Merged);
+  }
+  return true;
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -104,17 +234,44 @@ int main(int argc, char **argv) {
   auto Composite = make_unique<Module>("llvm-link", Context);
   Linker L(Composite.get(), diagnosticHandler);
 
-  for (unsigned i = 0; i < InputFilenames.size(); ++i) {
-    std::unique_ptr<Module> M = loadFile(argv[0], InputFilenames[i], Context);
-    if (!M.get()) {
-      errs() << argv[0] << ": error loading file '" <<InputFilenames[i]<< "'\n";
+  // There is no point in having more threads than inputs.
+  unsigned Threads = NumThreads;
+  if (Threads == 0)
+    Threads = ThreadPool::getDefaultConcurrency();
+  Threads = std::max(1u, std::min(Threads, unsigned(InputFilenames.size())));
+
+  if (Threads > 1) {
+    // What -only-needed links in from an input depends on everything linked
+    // before it, so it can't be split into independent runs.
+    if (OnlyNeeded) {
+      errs() << argv[0] << ": -only-needed can't be used with -num-threads\n";
       return 1;
     }
 
-    if (Verbose) errs() << "Linking in '" << InputFilenames[i] << "'\n";
-
-    if (L.linkInModule(M.get()))
+    std::vector<SmallVector<char, 0>> Bitcodes;
+    if (!linkInParallel(argv[0], Threads, Bitcodes))
       return 1;
+    for (const auto &Bitcode : Bitcodes) {
+      std::unique_ptr<Module> M = loadBitcode(Bitcode, Context);
+      if (L.linkInModule(M.get()))
+        return 1;
+    }
+  } else {
+    for (unsigned i = 0; i < InputFilenames.size(); ++i) {
+      std::unique_ptr<Module> M =
+          loadFile(argv[0], InputFilenames[i], Context);
+      if (!M.get())
+        return 1;
+
+      // The first input is linked in full, so that its definitions are what
+      // the rest of the link is pulled in from.
+      unsigned Flags = Linker::Flags::None;
+      if (OnlyNeeded && i != 0)
+        Flags = Linker::Flags::LinkOnlyNeeded;
+
+      if (L.linkInModule(M.get(), Flags))
+        return 1;
+    }
   }
 
   if (DumpAsm) errs() << "Here's the assembly:\n" << *Composite;
@@ -51,9 +51,28 @@ OutputFilename("o", cl::desc("Output filename"),
 static cl::opt<bool>
 ShowEncoding("show-encoding", cl::desc("Show instruction encodings"));
 
+static cl::opt<DebugCompression::Type>
+CompressDebugSections("compress-debug-sections", cl::ValueOptional,
+  cl::init(DebugCompression::None),
+  cl::desc("Compress DWARF debug sections:"),
+  cl::values(
+    clEnumValN(DebugCompression::ZlibGnu, "", "Into .zdebug_* sections"),
+    clEnumValN(DebugCompression::None, "none", "No compression"),
+    clEnumValN(DebugCompression::Zlib, "zlib",
+               "Into SHF_COMPRESSED sections"),
+    clEnumValN(DebugCompression::ZlibGnu, "zlib-gnu",
+               "Into .zdebug_* sections"),
+    clEnumValEnd));
+
+static cl::opt<bool>
+ParallelObjectWriting("parallel-object-writing",
+                      cl::desc("Write object file sections on several threads "
+                               "(holds the whole object file in memory)"));
+
 static cl::opt<bool>
-CompressDebugSections("compress-debug-sections",
-                      cl::desc("Compress DWARF debug sections"));
+FastStringTables("fast-string-tables",
+                 cl::desc("Don't merge string suffixes in object file string "
+                          "tables (faster, but the tables are larger)"));
 
 static cl::opt<bool>
 ShowInst("show-inst", cl::desc("Show internal instruction representation"));
@@ -389,15 +408,21 @@ int main(int argc, char **argv) {
   std::unique_ptr<MCAsmInfo> MAI(TheTarget->createMCAsmInfo(*MRI, TripleName));
   assert(MAI && "Unable to create target asm info!");
 
-  if (CompressDebugSections) {
+  if (CompressDebugSections != DebugCompression::None) {
     if (!zlib::isAvailable()) {
       errs() << ProgName
              << ": build tools with zlib to enable -compress-debug-sections";
       return 1;
     }
-    MAI->setCompressDebugSections(true);
+    MAI->setCompressDebugSections(CompressDebugSections);
   }
 
+  if (ParallelObjectWriting)
+    MAI->setParallelObjectWriting(true);
+
+  if (FastStringTables)
+    MAI->setFastStringTables(true);
+
   // FIXME: This is not pretty. MCContext has a ptr to MCObjectFileInfo and
   // MCObjectFileInfo needs a MCContext reference in order to initialize itself.
   MCObjectFileInfo MOFI;
@@ -49,10 +49,12 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <mutex>
 #include <system_error>
 
 using namespace llvm;
@@ -147,9 +149,18 @@ static cl::alias
 PrivateHeadersShort("p", cl::desc("Alias for --private-headers"),
                     cl::aliasopt(PrivateHeaders));
 
+static cl::opt<unsigned>
+NumThreads("num-threads", cl::init(1),
+           cl::desc("Number of threads to disassemble with "
+                    "(0 = one per hardware thread)"));
+
 static StringRef ToolName;
 static int ReturnValue = EXIT_SUCCESS;
 
+/// The threads to disassemble on, shared by all the objects being dumped.
+/// Null if disassembling on the main thread.
+static std::unique_ptr<ThreadPool> DisassemblyPool;
+
 bool llvm::error(std::error_code EC) {
   if (!EC)
     return false;
@@ -195,6 +206,10 @@ static const Target *getTarget(const ObjectFile *Obj = nullptr) {
 }
 
 void llvm::DumpBytes(StringRef bytes) {
+  DumpBytes(bytes, outs());
+}
+
+void llvm::DumpBytes(StringRef bytes, raw_ostream &OS) {
   static const char hex_rep[] = "0123456789abcdef";
   // FIXME: The real way to do this is to figure out the longest instruction
   //        and align to that size before printing. I'll fix this when I get
@@ -217,7 +232,7 @@ void llvm::DumpBytes(StringRef bytes) {
   }
 
   output[sizeof(output) - 1] = 0;
-  outs() << output;
+  OS << output;
 }
 
 bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
@@ -227,6 +242,257 @@ bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
   return a_addr < b_addr;
 }
 
+namespace {
+/// The symbols and relocations of an object file, sorted by the section they
+/// belong to and then by address. It is built once per object, so that
+/// disassembling a section only has to binary search for its own entries
+/// instead of walking every symbol and relocation of the object again.
+class SectionAddressIndex {
+public:
+  struct SymbolEntry {
+    SectionRef Section;
+    uint64_t Address;
+    StringRef Name;
+  };
+
+  /// A relocation, keyed by the section it applies to rather than the section
+  /// it is stored in, with its offset read once up front.
+  struct RelocationEntry {
+    SectionRef Section;
+    uint64_t Offset;
+    RelocationRef Reloc;
+  };
+
+  SectionAddressIndex(const ObjectFile *Obj, bool IndexRelocations);
+
+  /// Returns the symbols in \p Section, sorted by address and then by name.
+  ArrayRef<SymbolEntry> symbols(const SectionRef &Section) const;
+
+  /// Returns the relocations that apply to \p Section, sorted by offset.
+  ArrayRef<RelocationEntry> relocations(const SectionRef &Section) const;
+
+private:
+  std::vector<SymbolEntry> Symbols;
+  std::vector<RelocationEntry> Relocations;
+};
+}
+
+SectionAddressIndex::SectionAddressIndex(const ObjectFile *Obj,
+                                         bool IndexRelocations) {
+  for (const SymbolRef &Symbol : Obj->symbols()) {
+    section_iterator Section = Obj->section_end();
+    if (error(Symbol.getSection(Section)))
+      break;
+    if (Section == Obj->section_end())
+      continue;
+    uint64_t Address;
+    if (error(Symbol.getAddress(Address)))
+      break;
+    if (Address == UnknownAddressOrSize)
+      continue;
+    StringRef Name;
+    if (error(Symbol.getName(Name)))
+      break;
+    Symbols.push_back({*Section, Address, Name});
+  }
+  std::sort(Symbols.begin(), Symbols.end(),
+            [](const SymbolEntry &A, const SymbolEntry &B) {
+    if (A.Section != B.Section)
+      return A.Section < B.Section;
+    if (A.Address != B.Address)
+      return A.Address < B.Address;
+    return A.Name < B.Name;
+  });
+
+  if (!IndexRelocations)
+    return;
+  for (const SectionRef &RelocSec : Obj->sections()) {
+    section_iterator Section = RelocSec.getRelocatedSection();
+    if (Section == Obj->section_end())
+      continue;
+    for (const RelocationRef &Reloc : RelocSec.relocations()) {
+      uint64_t Offset;
+      if (error(Reloc.getOffset(Offset)))
+        continue;
+      Relocations.push_back({*Section, Offset, Reloc});
+    }
+  }
+  // Keep relocations at the same offset in the order they appear in.
+  std::stable_sort(Relocations.begin(), Relocations.end(),
+                   [](const RelocationEntry &A, const RelocationEntry &B) {
+    if (A.Section != B.Section)
+      return A.Section < B.Section;
+    return A.Offset < B.Offset;
+  });
+}
+
+ArrayRef<SectionAddressIndex::SymbolEntry>
+SectionAddressIndex::symbols(const SectionRef &Section) const {
+  auto Range = std::equal_range(
+      Symbols.begin(), Symbols.end(), SymbolEntry{Section, 0, StringRef()},
+      [](const SymbolEntry &A, const SymbolEntry &B) {
+        return A.Section < B.Section;
+      });
+  return makeArrayRef(Symbols.data() + (Range.first - Symbols.begin()),
+                      Range.second - Range.first);
+}
+
+ArrayRef<SectionAddressIndex::RelocationEntry>
+SectionAddressIndex::relocations(const SectionRef &Section) const {
+  auto Range = std::equal_range(
+      Relocations.begin(), Relocations.end(),
+      RelocationEntry{Section, 0, RelocationRef()},
+      [](const RelocationEntry &A, const RelocationEntry &B) {
+        return A.Section < B.Section;
+      });
+  return makeArrayRef(Relocations.data() + (Range.first - Relocations.begin()),
+                      Range.second - Range.first);
+}
+
+namespace {
+/// The state that disassembling and printing instructions mutates. The rest
+/// of the target description is only read, and is shared between threads.
+struct DisassemblerContext {
+  std::unique_ptr<MCContext> Ctx;
+  std::unique_ptr<MCDisassembler> DisAsm;
+  std::unique_ptr<MCInstPrinter> IP;
+};
+
+/// Hands out DisassemblerContexts to the threads of a parallel disassembly,
+/// creating a new one only when all the existing ones are in use.
+class DisassemblerContextPool {
+  const Target &TheTarget;
+  const MCAsmInfo &AsmInfo;
+  const MCRegisterInfo &MRI;
+  const MCObjectFileInfo &MOFI;
+  const MCSubtargetInfo &STI;
+  const MCInstrInfo &MII;
+  int AsmPrinterVariant;
+
+  std::mutex Lock;
+  std::vector<std::unique_ptr<DisassemblerContext>> Free;
+
+public:
+  DisassemblerContextPool(const Target &TheTarget, const MCAsmInfo &AsmInfo,
+                          const MCRegisterInfo &MRI,
+                          const MCObjectFileInfo &MOFI,
+                          const MCSubtargetInfo &STI, const MCInstrInfo &MII,
+                          int AsmPrinterVariant)
+      : TheTarget(TheTarget), AsmInfo(AsmInfo), MRI(MRI), MOFI(MOFI), STI(STI),
+        MII(MII), AsmPrinterVariant(AsmPrinterVariant) {}
+
+  std::unique_ptr<DisassemblerContext> take() {
+    {
+      std::lock_guard<std::mutex> Guard(Lock);
+      if (!Free.empty()) {
+        std::unique_ptr<DisassemblerContext> DC = std::move(Free.back());
+        Free.pop_back();
+        return DC;
+      }
+    }
+    // DisassembleObject has already checked that the target can create
+    // these, so they don't fail here.
+    std::unique_ptr<DisassemblerContext> DC(new DisassemblerContext);
+    DC->Ctx.reset(new MCContext(&AsmInfo, &MRI, &MOFI));
+    DC->DisAsm.reset(TheTarget.createMCDisassembler(STI, *DC->Ctx));
+    DC->IP.reset(TheTarget.createMCInstPrinter(AsmPrinterVariant, AsmInfo,
+                                               MII, MRI, STI));
+    return DC;
+  }
+
+  void give(std::unique_ptr<DisassemblerContext> DC) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Free.push_back(std::move(DC));
+  }
+};
+
+/// The instructions of a section from one symbol to the next, along with the
+/// relocations to print inline with them.
+struct DisassemblyChunk {
+  StringRef SymbolName;
+  uint64_t Start;
+  uint64_t End;
+  ArrayRef<SectionAddressIndex::RelocationEntry> Rels;
+};
+}
+
+/// Disassemble \p Chunk of the section whose contents are \p Bytes, printing
+/// the instructions to \p OS and warnings to \p WarningOS. This only reads
+/// the object file, so chunks can be disassembled on several threads as long
+/// as each has its own disassembler and printer. Returns false if reading a
+/// relocation failed, after printing the error to \p WarningOS.
+static bool DisassembleChunk(const DisassemblyChunk &Chunk,
+                             ArrayRef<uint8_t> Bytes, uint64_t SectionAddr,
+                             StringRef Fmt, const MCDisassembler &DisAsm,
+                             MCInstPrinter &IP, raw_ostream &OS,
+                             raw_ostream &WarningOS, raw_ostream &DebugOut) {
+  bool Success = true;
+  auto Failed = [&](std::error_code EC) {
+    if (!EC)
+      return false;
+    WarningOS << ToolName << ": error reading file: " << EC.message() << ".\n";
+    Success = false;
+    return true;
+  };
+
+  SmallString<40> Comments;
+  raw_svector_ostream CommentStream(Comments);
+
+  OS << '\n' << Chunk.SymbolName << ":\n";
+
+  uint64_t Size;
+  const SectionAddressIndex::RelocationEntry *rel_cur = Chunk.Rels.begin();
+  const SectionAddressIndex::RelocationEntry *rel_end = Chunk.Rels.end();
+  for (uint64_t Index = Chunk.Start; Index < Chunk.End; Index += Size) {
+    MCInst Inst;
+
+    if (DisAsm.getInstruction(Inst, Size, Bytes.slice(Index),
+                              SectionAddr + Index, DebugOut, CommentStream)) {
+      OS << format("%8" PRIx64 ":", SectionAddr + Index);
+      if (!NoShowRawInsn) {
+        OS << "\t";
+        DumpBytes(StringRef(reinterpret_cast<const char *>(Bytes.data()) +
+                                Index,
+                            Size),
+                  OS);
+      }
+      IP.printInst(&Inst, OS, "");
+      OS << CommentStream.str();
+      Comments.clear();
+      OS << "\n";
+    } else {
+      WarningOS << ToolName << ": warning: invalid instruction encoding\n";
+      if (Size == 0)
+        Size = 1; // skip illegible bytes
+    }
+
+    // Print relocation for instruction.
+    while (rel_cur != rel_end) {
+      bool hidden = false;
+      uint64_t addr;
+      SmallString<16> name;
+      SmallString<32> val;
+
+      // If this relocation is hidden, skip it.
+      if (Failed(rel_cur->Reloc.getHidden(hidden))) goto skip_print_rel;
+      if (hidden) goto skip_print_rel;
+
+      addr = rel_cur->Offset;
+      // Stop when rel_cur's address is past the current instruction.
+      if (addr >= Index + Size) break;
+      if (Failed(rel_cur->Reloc.getTypeName(name))) goto skip_print_rel;
+      if (Failed(rel_cur->Reloc.getValueString(val))) goto skip_print_rel;
+
+      OS << format(Fmt.data(), SectionAddr + addr) << name << "\t" << val
+         << "\n";
+
+    skip_print_rel:
+      ++rel_cur;
+    }
+  }
+  return Success;
+}
+
 static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   const Target *TheTarget = getTarget(Obj);
   // getTarget() will have already issued a diagnostic if necessary, so
@@ -297,15 +563,13 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   StringRef Fmt = Obj->getBytesInAddress() > 4 ? "\t\t%016" PRIx64 ":  " :
                                                  "\t\t\t%08" PRIx64 ":  ";
 
-  // Create a mapping, RelocSecs = SectionRelocMap[S], where sections
-  // in RelocSecs contain the relocations for section S.
-  std::error_code EC;
-  std::map<SectionRef, SmallVector<SectionRef, 1>> SectionRelocMap;
-  for (const SectionRef &Section : Obj->sections()) {
-    section_iterator Sec2 = Section.getRelocatedSection();
-    if (Sec2 != Obj->section_end())
-      SectionRelocMap[*Sec2].push_back(Section);
-  }
+  ThreadPool *Pool = DisassemblyPool.get();
+  std::unique_ptr<DisassemblerContextPool> Contexts;
+  if (Pool)
+    Contexts.reset(new DisassemblerContextPool(
+        *TheTarget, *AsmInfo, *MRI, *MOFI, *STI, *MII, AsmPrinterVariant));
+
+  SectionAddressIndex AddrIndex(Obj, InlineRelocs);
 
   for (const SectionRef &Section : Obj->sections()) {
     if (!Section.isText() || Section.isVirtual())
@@ -316,41 +580,25 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     if (!SectSize)
       continue;
 
-    // Make a list of all the symbols in this section.
+    // Make a list of all the symbols in this section, relative to its start.
+    ArrayRef<SectionAddressIndex::SymbolEntry> SectionSymbols =
+        AddrIndex.symbols(Section);
+    auto SymbolAddressLess = [](const SectionAddressIndex::SymbolEntry &Sym,
+                                uint64_t Address) {
+      return Sym.Address < Address;
+    };
+    const SectionAddressIndex::SymbolEntry *SymBegin = std::lower_bound(
+        SectionSymbols.begin(), SectionSymbols.end(), SectionAddr,
+        SymbolAddressLess);
     std::vector<std::pair<uint64_t, StringRef>> Symbols;
-    for (const SymbolRef &Symbol : Obj->symbols()) {
-      if (Section.containsSymbol(Symbol)) {
-        uint64_t Address;
-        if (error(Symbol.getAddress(Address)))
-          break;
-        if (Address == UnknownAddressOrSize)
-          continue;
-        Address -= SectionAddr;
-        if (Address >= SectSize)
-          continue;
-
-        StringRef Name;
-        if (error(Symbol.getName(Name)))
-          break;
-        Symbols.push_back(std::make_pair(Address, Name));
-      }
-    }
-
-    // Sort the symbols by address, just in case they didn't come in that way.
-    array_pod_sort(Symbols.begin(), Symbols.end());
-
-    // Make a list of all the relocations for this section.
-    std::vector<RelocationRef> Rels;
-    if (InlineRelocs) {
-      for (const SectionRef &RelocSec : SectionRelocMap[Section]) {
-        for (const RelocationRef &Reloc : RelocSec.relocations()) {
-          Rels.push_back(Reloc);
-        }
-      }
-    }
+    for (const SectionAddressIndex::SymbolEntry *Sym = SymBegin,
+                                                *SymEnd = SectionSymbols.end();
+         Sym != SymEnd && Sym->Address - SectionAddr < SectSize; ++Sym)
+      Symbols.push_back(std::make_pair(Sym->Address - SectionAddr, Sym->Name));
 
-    // Sort relocations by address.
-    std::sort(Rels.begin(), Rels.end(), RelocAddressLess);
+    // The relocations for this section, sorted by offset.
+    ArrayRef<SectionAddressIndex::RelocationEntry> Rels =
+        AddrIndex.relocations(Section);
 
     StringRef SegmentName = "";
     if (const MachOObjectFile *MachO = dyn_cast<const MachOObjectFile>(Obj)) {
@@ -371,23 +619,18 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
       Symbols.push_back(std::make_pair(0, name));
 
 
-    SmallString<40> Comments;
-    raw_svector_ostream CommentStream(Comments);
-
     StringRef BytesStr;
     if (error(Section.getContents(BytesStr)))
       break;
     ArrayRef<uint8_t> Bytes(reinterpret_cast<const uint8_t *>(BytesStr.data()),
                             BytesStr.size());
 
-    uint64_t Size;
-    uint64_t Index;
-
-    std::vector<RelocationRef>::const_iterator rel_cur = Rels.begin();
-    std::vector<RelocationRef>::const_iterator rel_end = Rels.end();
-    // Disassemble symbol by symbol.
+    // Split the section at symbol boundaries. Each chunk gets the relocations
+    // up to the start of the next one, so that chunks can be disassembled
+    // independently and still print exactly what a single pass would.
+    std::vector<DisassemblyChunk> Chunks;
+    const SectionAddressIndex::RelocationEntry *RelBegin = Rels.begin();
     for (unsigned si = 0, se = Symbols.size(); si != se; ++si) {
-
       uint64_t Start = Symbols[si].first;
       // The end is either the section end or the beginning of the next symbol.
       uint64_t End = (si == se - 1) ? SectSize : Symbols[si + 1].first;
@@ -395,60 +638,73 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
       if (Start == End)
         continue;
 
-      outs() << '\n' << Symbols[si].second << ":\n";
+      DisassemblyChunk Chunk;
+      Chunk.SymbolName = Symbols[si].second;
+      Chunk.Start = Start;
+      Chunk.End = End;
+      const SectionAddressIndex::RelocationEntry *RelEnd =
+          si == se - 1
+              ? Rels.end()
+              : std::lower_bound(
+                    RelBegin, Rels.end(), End,
+                    [](const SectionAddressIndex::RelocationEntry &Rel,
+                       uint64_t Offset) { return Rel.Offset < Offset; });
+      Chunk.Rels = makeArrayRef(RelBegin, RelEnd);
+      RelBegin = RelEnd;
+      Chunks.push_back(Chunk);
+    }
 
+    if (!Pool) {
 #ifndef NDEBUG
       raw_ostream &DebugOut = DebugFlag ? dbgs() : nulls();
 #else
       raw_ostream &DebugOut = nulls();
 #endif
+      for (const DisassemblyChunk &Chunk : Chunks)
+        if (!DisassembleChunk(Chunk, Bytes, SectionAddr, Fmt, *DisAsm, *IP,
+                              outs(), errs(), DebugOut))
+          ReturnValue = EXIT_FAILURE;
+      continue;
+    }
 
-      for (Index = Start; Index < End; Index += Size) {
-        MCInst Inst;
-
-        if (DisAsm->getInstruction(Inst, Size, Bytes.slice(Index),
-                                   SectionAddr + Index, DebugOut,
-                                   CommentStream)) {
-          outs() << format("%8" PRIx64 ":", SectionAddr + Index);
-          if (!NoShowRawInsn) {
-            outs() << "\t";
-            DumpBytes(StringRef(
-                reinterpret_cast<const char *>(Bytes.data()) + Index, Size));
-          }
-          IP->printInst(&Inst, outs(), "");
-          outs() << CommentStream.str();
-          Comments.clear();
-          outs() << "\n";
-        } else {
-          errs() << ToolName << ": warning: invalid instruction encoding\n";
-          if (Size == 0)
-            Size = 1; // skip illegible bytes
-        }
-
-        // Print relocation for instruction.
-        while (rel_cur != rel_end) {
-          bool hidden = false;
-          uint64_t addr;
-          SmallString<16> name;
-          SmallString<32> val;
-
-          // If this relocation is hidden, skip it.
-          if (error(rel_cur->getHidden(hidden))) goto skip_print_rel;
-          if (hidden) goto skip_print_rel;
-
-          if (error(rel_cur->getOffset(addr))) goto skip_print_rel;
-          // Stop when rel_cur's address is past the current instruction.
-          if (addr >= Index + Size) break;
-          if (error(rel_cur->getTypeName(name))) goto skip_print_rel;
-          if (error(rel_cur->getValueString(val))) goto skip_print_rel;
-
-          outs() << format(Fmt.data(), SectionAddr + addr) << name
-                 << "\t" << val << "\n";
-
-        skip_print_rel:
-          ++rel_cur;
-        }
+    // Disassemble the chunks on the pool, each into its own buffer, and print
+    // the buffers in address order. At most Window chunks are in flight, so
+    // the output for a large section is never all held in memory at once.
+    struct ChunkOutput {
+      std::string Text;
+      std::string Warnings;
+      bool Success;
+      std::shared_future<void> Done;
+    };
+    const size_t Window = 16 * Pool->getThreadCount();
+    std::vector<ChunkOutput> Outputs(std::min(Window, Chunks.size()));
+    size_t Submitted = 0;
+    for (size_t Printed = 0, E = Chunks.size(); Printed != E; ++Printed) {
+      for (; Submitted != E && Submitted < Printed + Window; ++Submitted) {
+        ChunkOutput &Out = Outputs[Submitted % Window];
+        const DisassemblyChunk &Chunk = Chunks[Submitted];
+        Out.Done = Pool->async([&Out, &Chunk, &Contexts, Bytes, SectionAddr,
+                                Fmt] {
+          std::unique_ptr<DisassemblerContext> DC = Contexts->take();
+          raw_string_ostream OS(Out.Text), WarningOS(Out.Warnings);
+          raw_null_ostream DebugOut;
+          Out.Success = DisassembleChunk(Chunk, Bytes, SectionAddr, Fmt,
+                                         *DC->DisAsm, *DC->IP, OS, WarningOS,
+                                         DebugOut);
+          OS.flush();
+          WarningOS.flush();
+          Contexts->give(std::move(DC));
+        });
       }
+
+      ChunkOutput &Out = Outputs[Printed % Window];
+      Out.Done.wait();
+      outs() << Out.Text;
+      errs() << Out.Warnings;
+      if (!Out.Success)
+        ReturnValue = EXIT_FAILURE;
+      Out.Text.clear();
+      Out.Warnings.clear();
     }
   }
 }
@@ -912,6 +1168,11 @@ int main(int argc, char **argv) {
     return 2;
   }
 
+  unsigned Threads =
+      NumThreads ? NumThreads : ThreadPool::getDefaultConcurrency();
+  if (Disassemble && Threads > 1)
+    DisassemblyPool.reset(new ThreadPool(Threads));
+
   std::for_each(InputFilenames.begin(), InputFilenames.end(),
                 DumpInput);
 
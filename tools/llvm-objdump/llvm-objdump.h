@@ -21,6 +21,7 @@ namespace object {
   class ObjectFile;
   class RelocationRef;
 }
+class raw_ostream;
 
 extern cl::opt<std::string> TripleName;
 extern cl::opt<std::string> ArchName;
@@ -50,6 +51,7 @@ extern cl::opt<bool> UnwindInfo;
 bool error(std::error_code ec);
 bool RelocAddressLess(object::RelocationRef a, object::RelocationRef b);
 void DumpBytes(StringRef bytes);
+void DumpBytes(StringRef bytes, raw_ostream &OS);
 void ParseInputMachO(StringRef Filename);
 void printCOFFUnwindInfo(const object::COFFObjectFile* o);
 void printMachOUnwindInfo(const object::MachOObjectFile* o);
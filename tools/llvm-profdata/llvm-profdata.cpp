@@ -11,6 +11,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ProfileData/InstrProfReader.h"
@@ -24,7 +26,9 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -38,8 +42,70 @@ static void exitWithError(const Twine &Message, StringRef Whence = "") {
 
 enum ProfileKinds { instr, sample };
 
+namespace {
+/// A writer for a subset of the inputs, together with what went wrong while
+/// reading them. Each is only ever used by one thread at a time.
+struct WriterContext {
+  InstrProfWriter Writer;
+  std::error_code Err;
+  std::string ErrWhence;
+  std::vector<std::string> Warnings;
+  /// If merging on several threads, the input each function name and hash
+  /// was first read from, to name it if the function can't be merged with
+  /// the records of another writer.
+  bool TrackOrigins;
+  StringMap<SmallDenseMap<uint64_t, StringRef, 1>> Origins;
+
+  WriterContext() : TrackOrigins(false) {}
+};
+}
+
+static void loadInput(StringRef Filename, WriterContext &WC) {
+  auto ReaderOrErr = InstrProfReader::create(Filename);
+  if ((WC.Err = ReaderOrErr.getError())) {
+    WC.ErrWhence = Filename;
+    return;
+  }
+
+  auto Reader = std::move(ReaderOrErr.get());
+  for (const auto &I : *Reader) {
+    if (std::error_code EC =
+            WC.Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
+      WC.Warnings.push_back((Filename + ": " + I.Name + ": " + EC.message())
+                                .str());
+    else if (WC.TrackOrigins)
+      WC.Origins[I.Name].insert(std::make_pair(I.Hash, Filename));
+  }
+  if (Reader->hasError()) {
+    WC.Err = Reader->getError();
+    WC.ErrWhence = Filename;
+  }
+}
+
+/// Merge the profile of \p Src, which was read from the inputs following
+/// those of \p Dst, into \p Dst, leaving \p Src empty.
+static void mergeWriterContexts(WriterContext &Dst, WriterContext &Src) {
+  Dst.Warnings.insert(Dst.Warnings.end(), Src.Warnings.begin(),
+                      Src.Warnings.end());
+  Src.Warnings.clear();
+  Dst.Writer.mergeRecordsFromWriter(
+      std::move(Src.Writer),
+      [&](StringRef FunctionName, uint64_t FunctionHash, std::error_code EC) {
+        StringRef Filename = Src.Origins[FunctionName].lookup(FunctionHash);
+        Dst.Warnings.push_back(
+            (Filename + ": " + FunctionName + ": " + EC.message()).str());
+      });
+  Src.Origins.clear();
+}
+
+static void reportWarnings(WriterContext &WC) {
+  for (const std::string &Warning : WC.Warnings)
+    errs() << Warning << "\n";
+  WC.Warnings.clear();
+}
+
 void mergeInstrProfile(const cl::list<std::string> &Inputs,
-                       StringRef OutputFilename) {
+                       StringRef OutputFilename, unsigned NumThreads) {
   if (OutputFilename.compare("-") == 0)
     exitWithError("Cannot write indexed profdata format to stdout.");
 
@@ -48,21 +114,69 @@ void mergeInstrProfile(const cl::list<std::string> &Inputs,
   if (EC)
     exitWithError(EC.message(), OutputFilename);
 
-  InstrProfWriter Writer;
-  for (const auto &Filename : Inputs) {
-    auto ReaderOrErr = InstrProfReader::create(Filename);
-    if (std::error_code ec = ReaderOrErr.getError())
-      exitWithError(ec.message(), Filename);
+  // There is no point in having more writers than inputs.
+  if (NumThreads == 0)
+    NumThreads = ThreadPool::getDefaultConcurrency();
+  NumThreads = std::max(1u, std::min(NumThreads, unsigned(Inputs.size())));
+
+  WriterContext Merged;
+  if (NumThreads == 1) {
+    for (const auto &Filename : Inputs) {
+      loadInput(Filename, Merged);
+      reportWarnings(Merged);
+      if (Merged.Err)
+        exitWithError(Merged.Err.message(), Merged.ErrWhence);
+    }
+    Merged.Writer.write(Output);
+    return;
+  }
 
-    auto Reader = std::move(ReaderOrErr.get());
-    for (const auto &I : *Reader)
-      if (std::error_code EC =
-              Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
-        errs() << Filename << ": " << I.Name << ": " << EC.message() << "\n";
-    if (Reader->hasError())
-      exitWithError(Reader->getError().message(), Filename);
+  // The inputs are split into a few consecutive chunks per thread. Each
+  // thread reads a chunk into a writer of its own, and the chunks are merged
+  // into the final writer in input order as they complete, so the records of
+  // earlier inputs win as when merging on one thread. Only NumThreads chunks
+  // are read at the same time, and a writer is emptied by merging it before
+  // it takes the next chunk, so memory stays bounded by the merged profile
+  // plus NumThreads chunks rather than growing with NumThreads copies of it.
+  size_t NumChunks = std::min(Inputs.size(), size_t(NumThreads) * 4);
+  std::vector<std::unique_ptr<WriterContext>> Contexts;
+  for (unsigned I = 0; I < NumThreads; ++I) {
+    Contexts.emplace_back(make_unique<WriterContext>());
+    Contexts.back()->TrackOrigins = true;
+  }
+  std::vector<std::shared_future<void>> Chunks;
+
+  ThreadPool Pool(NumThreads);
+  auto ReadChunk = [&](size_t C) {
+    size_t Begin = Inputs.size() * C / NumChunks;
+    size_t End = Inputs.size() * (C + 1) / NumChunks;
+    Chunks.push_back(
+        Pool.async([&Inputs, Begin, End](WriterContext *WC) {
+          for (size_t I = Begin; I < End; ++I) {
+            loadInput(Inputs[I], *WC);
+            if (WC->Err)
+              return;
+          }
+        }, Contexts[C % NumThreads].get()));
+  };
+  for (size_t C = 0; C < NumThreads; ++C)
+    ReadChunk(C);
+
+  for (size_t C = 0; C < NumChunks; ++C) {
+    Chunks[C].wait();
+    WriterContext &WC = *Contexts[C % NumThreads];
+    reportWarnings(WC);
+    if (WC.Err) {
+      Pool.wait();
+      exitWithError(WC.Err.message(), WC.ErrWhence);
+    }
+    mergeWriterContexts(Merged, WC);
+    reportWarnings(Merged);
+    if (C + NumThreads < NumChunks)
+      ReadChunk(C + NumThreads);
   }
-  Writer.write(Output);
+
+  Merged.Writer.write(Output);
 }
 
 void mergeSampleProfile(const cl::list<std::string> &Inputs,
@@ -120,10 +234,17 @@ int merge_main(int argc, const char *argv[]) {
                  clEnumValN(sampleprof::SPF_GCC, "gcc", "GCC encoding"),
                  clEnumValEnd));
 
+  cl::opt<unsigned> NumThreads(
+      "num-threads", cl::init(1),
+      cl::desc("Number of threads merging instrumentation profiles "
+               "(0 = one per hardware thread)"));
+  cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                        cl::aliasopt(NumThreads));
+
   cl::ParseCommandLineOptions(argc, argv, "LLVM profile data merger\n");
 
   if (ProfileKind == instr)
-    mergeInstrProfile(Inputs, OutputFilename);
+    mergeInstrProfile(Inputs, OutputFilename, NumThreads);
   else
     mergeSampleProfile(Inputs, OutputFilename, OutputFormat);
 
@@ -154,8 +154,6 @@ getSectionNameIndex(const ELFO &Obj, typename ELFO::Elf_Sym_Iter Symbol,
   } else {
     if (SectionIndex == SHN_XINDEX)
       SectionIndex = Obj.getSymbolTableIndex(&*Symbol);
-    assert(SectionIndex != SHN_XINDEX &&
-           "getSymbolTableIndex should handle this");
     const typename ELFO::Elf_Shdr *Sec = Obj.getSection(SectionIndex);
     SectionName = errorOrDefault(Obj.getSectionName(Sec));
   }
@@ -451,11 +449,20 @@ static const EnumEntry<unsigned> ElfSectionFlags[] = {
   LLVM_READOBJ_ENUM_ENT(ELF, SHF_OS_NONCONFORMING),
   LLVM_READOBJ_ENUM_ENT(ELF, SHF_GROUP           ),
   LLVM_READOBJ_ENUM_ENT(ELF, SHF_TLS             ),
-  LLVM_READOBJ_ENUM_ENT(ELF, XCORE_SHF_CP_SECTION),
-  LLVM_READOBJ_ENUM_ENT(ELF, XCORE_SHF_DP_SECTION),
   LLVM_READOBJ_ENUM_ENT(ELF, SHF_MIPS_NOSTRIP    )
 };
 
+// SHF_COMPRESSED and XCORE_SHF_CP_SECTION share a bit, so which one is shown
+// depends on the machine.
+static const EnumEntry<unsigned> ElfCompressedSectionFlag[] = {
+  LLVM_READOBJ_ENUM_ENT(ELF, SHF_COMPRESSED)
+};
+
+static const EnumEntry<unsigned> ElfXCoreSectionFlags[] = {
+  LLVM_READOBJ_ENUM_ENT(ELF, XCORE_SHF_CP_SECTION),
+  LLVM_READOBJ_ENUM_ENT(ELF, XCORE_SHF_DP_SECTION)
+};
+
 static const char *getElfSegmentType(unsigned Arch, unsigned Type) {
   // Check potentially overlapped processor-specific
   // program header type.
@@ -581,7 +588,15 @@ void ELFDumper<ELFT>::printSections() {
     W.printHex("Type",
                getElfSectionType(Obj->getHeader()->e_machine, Section->sh_type),
                Section->sh_type);
-    W.printFlags ("Flags", Section->sh_flags, makeArrayRef(ElfSectionFlags));
+    SmallVector<EnumEntry<unsigned>, 16> SectionFlags(
+        std::begin(ElfSectionFlags), std::end(ElfSectionFlags));
+    if (Obj->getHeader()->e_machine == EM_XCORE)
+      SectionFlags.append(std::begin(ElfXCoreSectionFlags),
+                          std::end(ElfXCoreSectionFlags));
+    else
+      SectionFlags.append(std::begin(ElfCompressedSectionFlag),
+                          std::end(ElfCompressedSectionFlag));
+    W.printFlags ("Flags", Section->sh_flags, makeArrayRef(SectionFlags));
     W.printHex   ("Address", Section->sh_addr);
     W.printHex   ("Offset", Section->sh_offset);
     W.printNumber("Size", Section->sh_size);
@@ -14,6 +14,7 @@
 #include "LLVMSymbolize.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/config.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Support/Casting.h"
@@ -23,6 +24,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include <sstream>
 #include <stdlib.h>
 
@@ -462,6 +464,13 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   }
   DIContext *Context = DIContext::getDWARFContext(*Objects.second);
   assert(Context);
+  if (auto *DWARFCtx = dyn_cast<DWARFContext>(Context)) {
+    DWARFCtx->setMaxResidentUnits(Opts.MaxResidentUnits);
+    if (Opts.Preload) {
+      ThreadPool Pool;
+      DWARFCtx->preloadUnits(Pool);
+    }
+  }
   ModuleInfo *Info = new ModuleInfo(Objects.first, Context);
   Modules.insert(make_pair(ModuleName, Info));
   return Info;
@@ -39,6 +39,8 @@ public:
     FunctionNameKind PrintFunctions;
     bool PrintInlining : 1;
     bool Demangle : 1;
+    bool Preload : 1;
+    unsigned MaxResidentUnits;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
     Options(bool UseSymbolTable = true,
@@ -47,7 +49,8 @@ public:
             std::string DefaultArch = "")
         : UseSymbolTable(UseSymbolTable),
           PrintFunctions(PrintFunctions), PrintInlining(PrintInlining),
-          Demangle(Demangle), DefaultArch(DefaultArch) {}
+          Demangle(Demangle), Preload(false), MaxResidentUnits(0),
+          DefaultArch(DefaultArch) {}
   };
 
   LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
@@ -62,6 +65,11 @@ public:
   std::string
   symbolizeData(const std::string &ModuleName, uint64_t ModuleOffset);
   void flush();
+  // Loads the debug info of a module ahead of the first query, so that the
+  // queries themselves answer quickly.
+  void preloadModule(const std::string &ModuleName) {
+    getOrCreateModuleInfo(ModuleName);
+  }
   static std::string DemangleName(const std::string &Name);
 private:
   typedef std::pair<ObjectFile*, ObjectFile*> ObjectPair;
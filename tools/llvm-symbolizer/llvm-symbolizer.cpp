@@ -22,6 +22,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
@@ -67,6 +68,28 @@ ClDsymHint("dsym-hint", cl::ZeroOrMore,
            cl::desc("Path to .dSYM bundles to search for debug info for the "
                     "object files"));
 
+static cl::opt<bool>
+ClPreload("preload", cl::init(false),
+          cl::desc("Parse all the debug info of a module on several threads "
+                   "when it is first loaded (the -obj module is loaded at "
+                   "startup)"));
+
+static cl::opt<unsigned>
+ClMaxResidentUnits("max-resident-units", cl::init(0),
+                   cl::desc("Maximum number of compile units per module whose "
+                            "debug info is kept in memory between queries "
+                            "(0 = unlimited)"));
+
+static cl::opt<unsigned>
+ClRSSBatchSize("rss-batch-size", cl::init(0),
+               cl::desc("Print the resident set size to stderr after every "
+                        "N queries (0 = never)"));
+
+static void reportRSS(unsigned NumQueries) {
+  errs() << "queries=" << NumQueries << ' ';
+  sys::Process::PrintMemoryUsage(errs());
+}
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -125,6 +148,8 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv, "llvm-symbolizer\n");
   LLVMSymbolizer::Options Opts(ClUseSymbolTable, ClPrintFunctions,
                                ClPrintInlining, ClDemangle, ClDefaultArch);
+  Opts.Preload = ClPreload;
+  Opts.MaxResidentUnits = ClMaxResidentUnits;
   for (const auto &hint : ClDsymHint) {
     if (sys::path::extension(hint) == ".dSYM") {
       Opts.DsymHints.push_back(hint);
@@ -134,16 +159,23 @@ int main(int argc, char **argv) {
     }
   }
   LLVMSymbolizer Symbolizer(Opts);
+  if (ClPreload && !ClBinaryName.empty())
+    Symbolizer.preloadModule(ClBinaryName);
 
   bool IsData = false;
   std::string ModuleName;
   uint64_t ModuleOffset;
+  unsigned NumQueries = 0;
   while (parseCommand(IsData, ModuleName, ModuleOffset)) {
     std::string Result =
         IsData ? Symbolizer.symbolizeData(ModuleName, ModuleOffset)
                : Symbolizer.symbolizeCode(ModuleName, ModuleOffset);
     outs() << Result << "\n";
     outs().flush();
+    if (ClRSSBatchSize && ++NumQueries % ClRSSBatchSize == 0)
+      reportRSS(NumQueries);
   }
+  if (ClRSSBatchSize && NumQueries % ClRSSBatchSize != 0)
+    reportRSS(NumQueries);
   return 0;
 }
@@ -46,6 +46,7 @@
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
@@ -178,6 +179,16 @@ DefaultDataLayout("default-data-layout",
           cl::desc("data layout string to use if not specified by module"),
           cl::value_desc("layout-string"), cl::init(""));
 
+static cl::opt<unsigned>
+NumThreads("num-threads", cl::init(1),
+           cl::desc("Number of threads to run function passes on, for runs "
+                    "of passes that support it (0 = one per hardware "
+                    "thread)"));
+
+static cl::alias
+NumThreadsShort("j", cl::desc("Alias for --num-threads"),
+                cl::aliasopt(NumThreads));
+
 
 
 static inline void addPass(legacy::PassManagerBase &PM, Pass *P) {
@@ -409,6 +420,8 @@ int main(int argc, char **argv) {
   // about to build.
   //
   legacy::PassManager Passes;
+  Passes.setNumThreads(NumThreads ? NumThreads
+                                  : ThreadPool::getDefaultConcurrency());
 
   // Add an appropriate TargetLibraryInfo pass for the module's triple.
   TargetLibraryInfoImpl TLII(ModuleTriple);
@@ -49,12 +49,14 @@ static void writeModuleToBuffer(std::unique_ptr<Module> Mod,
 
 static std::unique_ptr<Module> getLazyModuleFromAssembly(LLVMContext &Context,
                                                          SmallString<1024> &Mem,
-                                                         const char *Assembly) {
+                                                         const char *Assembly,
+                                                         bool LazyMetadata =
+                                                             false) {
   writeModuleToBuffer(parseAssembly(Assembly), Mem);
   std::unique_ptr<MemoryBuffer> Buffer =
       MemoryBuffer::getMemBuffer(Mem.str(), "test", false);
   ErrorOr<Module *> ModuleOrErr =
-      getLazyBitcodeModule(std::move(Buffer), Context);
+      getLazyBitcodeModule(std::move(Buffer), Context, nullptr, LazyMetadata);
   return std::unique_ptr<Module>(ModuleOrErr.get());
 }
 
@@ -164,4 +166,55 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+TEST(BitReaderTest, LazyLoadMetadataOnMaterialize) {
+  SmallString<1024> Mem;
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = getLazyModuleFromAssembly(
+      Context, Mem, "define void @func() {\n"
+                    "  ret void, !foo !0\n"
+                    "}\n"
+                    "!llvm.named = !{!0}\n"
+                    "!0 = !{i32 42}\n",
+                    /*LazyMetadata=*/true);
+
+  // Module-level metadata is skipped until something asks for it.
+  EXPECT_EQ(nullptr, M->getNamedMetadata("llvm.named"));
+
+  // Materializing a function body pulls in the metadata it refers to.
+  EXPECT_FALSE(M->getFunction("func")->materialize());
+  NamedMDNode *NMD = M->getNamedMetadata("llvm.named");
+  ASSERT_NE(nullptr, NMD);
+  ASSERT_EQ(1u, NMD->getNumOperands());
+  Instruction &Ret = M->getFunction("func")->getEntryBlock().front();
+  EXPECT_EQ(NMD->getOperand(0), Ret.getMetadata("foo"));
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+}
+
+TEST(BitReaderTest, LazyLoadMetadataExplicit) {
+  SmallString<1024> Mem;
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = getLazyModuleFromAssembly(
+      Context, Mem, "define void @func() {\n"
+                    "  ret void\n"
+                    "}\n"
+                    "!llvm.named = !{!0, !1}\n"
+                    "!0 = !{i32 42}\n"
+                    "!1 = !{!\"str\"}\n",
+                    /*LazyMetadata=*/true);
+  EXPECT_EQ(nullptr, M->getNamedMetadata("llvm.named"));
+
+  EXPECT_FALSE(M->materializeMetadata());
+  NamedMDNode *NMD = M->getNamedMetadata("llvm.named");
+  ASSERT_NE(nullptr, NMD);
+  EXPECT_EQ(2u, NMD->getNumOperands());
+  EXPECT_TRUE(M->getFunction("func")->empty());
+
+  // Materializing again must not read the metadata twice.
+  EXPECT_FALSE(M->materializeAll());
+  EXPECT_EQ(2u, M->getNamedMetadata("llvm.named")->getNumOperands());
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+}
+
 } // end namespace
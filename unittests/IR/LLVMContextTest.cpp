@@ -0,0 +1,82 @@
+//===- llvm/unittest/IR/LLVMContextTest.cpp - LLVMContext unit tests ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Attributes.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/ThreadPool.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+namespace {
+
+#if LLVM_ENABLE_THREADS
+TEST(LLVMContextTest, ConcurrentUniquing) {
+  LLVMContext C;
+  EXPECT_FALSE(C.hasConcurrentUniquing());
+  C.enableConcurrentUniquing();
+  EXPECT_TRUE(C.hasConcurrentUniquing());
+
+  // Every thread uniques the same objects, in a different order, and they all
+  // have to get the same ones back. NumValues is prime, so that each thread's
+  // stride visits every index.
+  struct Uniqued {
+    Constant *Int;
+    Constant *FP;
+    Constant *Expr;
+    Type *Struct;
+    Type *Pointer;
+    AttributeSet Attrs;
+    Metadata *Tuple;
+  };
+  const unsigned NumThreads = 4, NumValues = 211;
+  std::vector<std::vector<Uniqued>> Results(
+      NumThreads, std::vector<Uniqued>(NumValues));
+  {
+    ThreadPool Pool(NumThreads);
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Pool.async([&C, &Results, T] {
+        for (unsigned J = 0; J != NumValues; ++J) {
+          unsigned I = (J * (2 * T + 1)) % NumValues;
+          Uniqued &U = Results[T][I];
+          IntegerType *IntTy = IntegerType::get(C, 8 + I);
+          U.Int = ConstantInt::get(IntTy, I);
+          U.FP = ConstantFP::get(Type::getDoubleTy(C), I);
+          U.Pointer = PointerType::getUnqual(IntTy);
+          U.Expr = ConstantExpr::getIntToPtr(U.Int, U.Pointer);
+          U.Struct = StructType::get(IntTy, U.Pointer, nullptr);
+          U.Attrs = AttributeSet::get(
+              C, AttributeSet::FunctionIndex,
+              AttrBuilder().addDereferenceableAttr(I + 1));
+          U.Tuple = MDTuple::get(C, {MDString::get(C, Twine(I).str()),
+                                     ConstantAsMetadata::get(U.Int)});
+        }
+      });
+  }
+
+  for (unsigned T = 1; T != NumThreads; ++T)
+    for (unsigned I = 0; I != NumValues; ++I) {
+      EXPECT_EQ(Results[0][I].Int, Results[T][I].Int);
+      EXPECT_EQ(Results[0][I].FP, Results[T][I].FP);
+      EXPECT_EQ(Results[0][I].Expr, Results[T][I].Expr);
+      EXPECT_EQ(Results[0][I].Struct, Results[T][I].Struct);
+      EXPECT_EQ(Results[0][I].Pointer, Results[T][I].Pointer);
+      EXPECT_EQ(Results[0][I].Attrs, Results[T][I].Attrs);
+      EXPECT_EQ(Results[0][I].Tuple, Results[T][I].Tuple);
+    }
+
+  C.disableConcurrentUniquing();
+  EXPECT_FALSE(C.hasConcurrentUniquing());
+}
+#endif
+
+} // end anonymous namespace
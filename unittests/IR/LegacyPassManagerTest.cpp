@@ -35,6 +35,7 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <atomic>
 
 using namespace llvm;
 
@@ -292,6 +293,84 @@ namespace llvm {
     };
     char OnTheFlyTest::ID=0;
 
+    // Points the return of each function fN at the constant N % 4, so that
+    // replicas running on other threads unique constants and update their use
+    // lists at the same time.
+    struct ReplicaFPass : public FunctionPass {
+    public:
+      static char ID;
+      static std::atomic<unsigned> NumReplicas;
+      static std::atomic<unsigned> NumRuns;
+      static std::atomic<unsigned> NumFinalizations;
+      ReplicaFPass() : FunctionPass(ID) { }
+      bool runOnFunction(Function &F) override {
+        ++NumRuns;
+        unsigned N;
+        F.getName().drop_front().getAsInteger(10, N);
+        ReturnInst *RI = cast<ReturnInst>(F.getEntryBlock().getTerminator());
+        RI->setOperand(0, ConstantInt::get(RI->getOperand(0)->getType(),
+                                           N % 4));
+        return true;
+      }
+      bool doFinalization(Module &M) override {
+        ++NumFinalizations;
+        return false;
+      }
+      Pass *createReplica() const override {
+        ++NumReplicas;
+        return new ReplicaFPass();
+      }
+    };
+    char ReplicaFPass::ID=0;
+    std::atomic<unsigned> ReplicaFPass::NumReplicas;
+    std::atomic<unsigned> ReplicaFPass::NumRuns;
+    std::atomic<unsigned> ReplicaFPass::NumFinalizations;
+
+    // Adds two private globals, one of whose names ends in digits, and stores
+    // to them in the function.
+    struct NewGlobalsFPass : public FunctionPass {
+    public:
+      static char ID;
+      NewGlobalsFPass() : FunctionPass(ID) { }
+      bool runOnFunction(Function &F) override {
+        Type *Int32Ty = Type::getInt32Ty(F.getContext());
+        Instruction *RI = F.getEntryBlock().getTerminator();
+        for (const char *Name : {"str", "foo2"}) {
+          GlobalVariable *GV = new GlobalVariable(
+              *F.getParent(), Int32Ty, false, GlobalValue::PrivateLinkage,
+              ConstantInt::get(Int32Ty, 0), Name);
+          new StoreInst(ConstantInt::get(Int32Ty, 1), GV, RI);
+        }
+        return true;
+      }
+      Pass *createReplica() const override { return new NewGlobalsFPass(); }
+    };
+    char NewGlobalsFPass::ID=0;
+
+    struct SequentialFPass : public FunctionPass {
+    public:
+      static char ID;
+      SequentialFPass() : FunctionPass(ID) { }
+      bool runOnFunction(Function &F) override {
+        return false;
+      }
+    };
+    char SequentialFPass::ID=0;
+
+    static void makeParallelTestModule(Module &M) {
+      LLVMContext &Context = M.getContext();
+      Type *Int32Ty = Type::getInt32Ty(Context);
+      FunctionType *FTy = FunctionType::get(Int32Ty, false);
+      for (unsigned I = 0; I != 64; ++I) {
+        Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                                       "f" + Twine(I), &M);
+        BasicBlock *BB = BasicBlock::Create(Context, "entry", F);
+        ReturnInst::Create(Context, ConstantInt::get(Int32Ty, 0), BB);
+      }
+      // Declarations aren't handed to function passes.
+      Function::Create(FTy, GlobalValue::ExternalLinkage, "decl", &M);
+    }
+
     TEST(PassManager, RunOnce) {
       Module M("test-once", getGlobalContext());
       struct ModuleNDNM *mNDNM = new ModuleNDNM();
@@ -406,6 +485,79 @@ namespace llvm {
       delete M;
     }
 
+    TEST(PassManager, ParallelFunctionPasses) {
+      LLVMContext Context;
+      Module M("test-parallel", Context);
+      makeParallelTestModule(M);
+
+      ReplicaFPass::NumReplicas = 0;
+      ReplicaFPass::NumRuns = 0;
+      ReplicaFPass::NumFinalizations = 0;
+      legacy::PassManager Passes;
+      Passes.setNumThreads(4);
+      Passes.add(new ReplicaFPass());
+      EXPECT_TRUE(Passes.run(M));
+
+      EXPECT_EQ(4u, ReplicaFPass::NumReplicas);
+      EXPECT_EQ(64u, ReplicaFPass::NumRuns);
+      // Only the original pass is finalized.
+      EXPECT_EQ(1u, ReplicaFPass::NumFinalizations);
+      // The context is only concurrent while the replicas run.
+      EXPECT_FALSE(Context.hasConcurrentUniquing());
+      Type *Int32Ty = Type::getInt32Ty(Context);
+      for (unsigned I = 0; I != 4; ++I)
+        EXPECT_EQ(16u, ConstantInt::get(Int32Ty, I)->getNumUses());
+      EXPECT_FALSE(verifyModule(M, &errs()));
+    }
+
+    TEST(PassManager, ParallelFunctionPassesNewGlobals) {
+      LLVMContext Context;
+      Module M("test-parallel-globals", Context);
+      makeParallelTestModule(M);
+
+      legacy::PassManager Passes;
+      Passes.setNumThreads(4);
+      Passes.add(new NewGlobalsFPass());
+      EXPECT_TRUE(Passes.run(M));
+
+      // The new globals are named in the order of the functions that use
+      // them. Only the suffixes the symbol table added are replaced, so the
+      // digits "foo2" asked for are kept.
+      auto UserOf = [&](StringRef Name) -> StringRef {
+        GlobalVariable *GV = M.getGlobalVariable(Name, true);
+        if (!GV || !GV->hasOneUse())
+          return "<none>";
+        return cast<Instruction>(GV->user_back())->getParent()->getParent()
+            ->getName();
+      };
+      EXPECT_EQ("f0", UserOf("str"));
+      EXPECT_EQ("f0", UserOf("foo2"));
+      EXPECT_EQ("f1", UserOf("str1"));
+      EXPECT_EQ("f1", UserOf("foo21"));
+      EXPECT_EQ("f63", UserOf("str63"));
+      EXPECT_EQ("f63", UserOf("foo263"));
+      EXPECT_EQ(nullptr, M.getNamedValue("foo"));
+      EXPECT_FALSE(verifyModule(M, &errs()));
+    }
+
+    TEST(PassManager, ParallelFunctionPassesFallBack) {
+      LLVMContext Context;
+      Module M("test-parallel-fallback", Context);
+      makeParallelTestModule(M);
+
+      // A pass that can't be replicated keeps the whole run sequential.
+      ReplicaFPass::NumRuns = 0;
+      legacy::PassManager Passes;
+      Passes.setNumThreads(4);
+      Passes.add(new ReplicaFPass());
+      Passes.add(new SequentialFPass());
+      EXPECT_TRUE(Passes.run(M));
+
+      EXPECT_EQ(64u, ReplicaFPass::NumRuns);
+      EXPECT_FALSE(Context.hasConcurrentUniquing());
+      EXPECT_FALSE(verifyModule(M, &errs()));
+    }
+
     Module* makeLLVMModule() {
       // Module Construction
       Module* mod = new Module("test-mem", getGlobalContext());
@@ -11,6 +11,7 @@
 #include "llvm/Support/Endian.h"
 #include "gtest/gtest.h"
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -68,4 +69,62 @@ TEST(StringTableBuilderTest, BasicWinCOFF) {
   EXPECT_EQ(23U, B.getOffset("river horse"));
 }
 
+TEST(StringTableBuilderTest, ELFInOrder) {
+  StringTableBuilder B;
+
+  B.add("foo");
+  B.add("bar");
+  B.add("foobar");
+  B.add("foo");
+
+  B.finalizeInOrder(StringTableBuilder::ELF);
+
+  std::string Expected;
+  Expected += '\x00';
+  Expected += "foo";
+  Expected += '\x00';
+  Expected += "bar";
+  Expected += '\x00';
+  Expected += "foobar";
+  Expected += '\x00';
+
+  EXPECT_EQ(Expected, B.data());
+  EXPECT_EQ(1U, B.getOffset("foo"));
+  EXPECT_EQ(5U, B.getOffset("bar"));
+  EXPECT_EQ(9U, B.getOffset("foobar"));
+}
+
+TEST(StringTableBuilderTest, ManySuffixes) {
+  StringTableBuilder B;
+
+  // Every string is a suffix of the next longer one with the same last
+  // character, and some characters are outside of ASCII.
+  std::vector<std::string> Strings;
+  const char Tails[] = {'a', 'b', '\x80', '\xff'};
+  for (char Tail : Tails) {
+    std::string S(1, Tail);
+    for (unsigned I = 0; I < 50; ++I) {
+      Strings.push_back(S);
+      S.insert(S.begin(), char('a' + I % 7));
+    }
+  }
+  for (const std::string &S : Strings)
+    B.add(S);
+
+  B.finalize(StringTableBuilder::ELF);
+
+  // Only the longest string of each chain needs to be in the table.
+  size_t ExpectedSize = 1;
+  for (unsigned I = 0; I < 4; ++I)
+    ExpectedSize += 50 + 1;
+  EXPECT_EQ(ExpectedSize, B.data().size());
+
+  for (const std::string &S : Strings) {
+    size_t Offset = B.getOffset(S);
+    ASSERT_LT(Offset + S.size(), B.data().size());
+    EXPECT_EQ(S, B.data().substr(Offset, S.size()));
+    EXPECT_EQ('\x00', B.data()[Offset + S.size()]);
+  }
+}
+
 }
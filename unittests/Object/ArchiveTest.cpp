@@ -0,0 +1,191 @@
+//===- llvm/unittest/Object/ArchiveTest.cpp - Archive tests ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/Archive.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace llvm;
+using namespace object;
+
+namespace {
+
+typedef std::vector<std::pair<std::string, unsigned>> SymbolList;
+
+void writeHeader(raw_ostream &OS, StringRef Name, uint64_t Size) {
+  OS << format("%-16s%-12u%-6u%-6u%-8o%-10llu`\n", Name.str().c_str(), 0U, 0U,
+               0U, 0644U, (unsigned long long)Size);
+}
+
+void writeBE32(std::string &Out, uint32_t V) {
+  Out += char(V >> 24);
+  Out += char(V >> 16);
+  Out += char(V >> 8);
+  Out += char(V);
+}
+
+// Lay out a GNU archive with members m0.o ... m<NumMembers-1>.o and a "/"
+// symbol table listing each (name, member) pair in order.
+std::string buildArchive(const SymbolList &Symbols, unsigned NumMembers) {
+  const std::string Member = "member\n";
+  std::string Names;
+  for (const auto &S : Symbols) {
+    Names += S.first;
+    Names += '\0';
+  }
+  uint64_t SymtabSize = 4 + 4 * Symbols.size() + Names.size();
+  uint64_t FirstMember = 8 + 60 + SymtabSize + (SymtabSize & 1);
+  uint64_t MemberStride = 60 + Member.size() + (Member.size() & 1);
+
+  std::string Symtab;
+  writeBE32(Symtab, Symbols.size());
+  for (const auto &S : Symbols)
+    writeBE32(Symtab, FirstMember + S.second * MemberStride);
+  Symtab += Names;
+
+  std::string Result;
+  raw_string_ostream OS(Result);
+  OS << "!<arch>\n";
+  writeHeader(OS, "/", Symtab.size());
+  OS << Symtab;
+  if (Symtab.size() & 1)
+    OS << '\n';
+  for (unsigned I = 0; I < NumMembers; ++I) {
+    writeHeader(OS, "m" + std::to_string(I) + ".o/", Member.size());
+    OS << Member;
+    if (Member.size() & 1)
+      OS << '\n';
+  }
+  return OS.str();
+}
+
+std::string getMemberName(const Archive &A, Archive::child_iterator I) {
+  if (I == A.child_end())
+    return "<none>";
+  ErrorOr<StringRef> NameOrErr = I->getName();
+  if (NameOrErr.getError())
+    return "<error>";
+  return *NameOrErr;
+}
+
+TEST(ArchiveTest, FindSym) {
+  SymbolList Symbols = {{"foo", 0}, {"bar", 1}, {"dup", 2}, {"baz", 1},
+                        {"dup", 0}};
+  std::string Data = buildArchive(Symbols, 3);
+  ErrorOr<std::unique_ptr<Archive>> ArchiveOrErr =
+      Archive::create(MemoryBufferRef(Data, "test.a"));
+  ASSERT_FALSE(ArchiveOrErr.getError());
+  const Archive &A = **ArchiveOrErr;
+
+  EXPECT_EQ("m0.o", getMemberName(A, A.findSym("foo")));
+  EXPECT_EQ("m1.o", getMemberName(A, A.findSym("bar")));
+  EXPECT_EQ("m1.o", getMemberName(A, A.findSym("baz")));
+  // The first symbol with a given name wins.
+  EXPECT_EQ("m2.o", getMemberName(A, A.findSym("dup")));
+  EXPECT_EQ("<none>", getMemberName(A, A.findSym("missing")));
+  EXPECT_EQ("<none>", getMemberName(A, A.findSym("fo")));
+  EXPECT_EQ("<none>", getMemberName(A, A.findSym("")));
+}
+
+TEST(ArchiveTest, FindSymLargeTable) {
+  const unsigned NumSymbols = 10000;
+  const unsigned NumMembers = 37;
+  SymbolList Symbols;
+  for (unsigned I = 0; I < NumSymbols; ++I)
+    Symbols.push_back(std::make_pair("sym" + std::to_string(I),
+                                     I % NumMembers));
+  std::string Data = buildArchive(Symbols, NumMembers);
+  ErrorOr<std::unique_ptr<Archive>> ArchiveOrErr =
+      Archive::create(MemoryBufferRef(Data, "test.a"));
+  ASSERT_FALSE(ArchiveOrErr.getError());
+  const Archive &A = **ArchiveOrErr;
+
+  for (unsigned I = 0; I < NumSymbols; ++I)
+    ASSERT_EQ("m" + std::to_string(I % NumMembers) + ".o",
+              getMemberName(A, A.findSym("sym" + std::to_string(I))));
+  EXPECT_EQ("<none>",
+            getMemberName(A, A.findSym("sym" + std::to_string(NumSymbols))));
+}
+
+TEST(ArchiveTest, FindSymNoSymbolTable) {
+  std::string Data = "!<arch>\n";
+  ErrorOr<std::unique_ptr<Archive>> ArchiveOrErr =
+      Archive::create(MemoryBufferRef(Data, "empty.a"));
+  ASSERT_FALSE(ArchiveOrErr.getError());
+  const Archive &A = **ArchiveOrErr;
+  EXPECT_FALSE(A.hasSymbolTable());
+  EXPECT_TRUE(A.findSym("foo") == A.child_end());
+}
+
+// Prints the cost of building the index on the first findSym and of each
+// later lookup in a table of 1M symbols, next to a walk of the symbol table.
+// This is a benchmark rather than a test, run it explicitly with
+// --gtest_also_run_disabled_tests.
+TEST(ArchiveTest, DISABLED_FindSymThroughput) {
+  const unsigned NumSymbols = 1000000;
+  const unsigned NumMembers = 1000;
+  const unsigned NumLookups = 1000000;
+  const unsigned NumWalks = 100;
+  SymbolList Symbols;
+  for (unsigned I = 0; I < NumSymbols; ++I)
+    Symbols.push_back(std::make_pair("_ZN4llvm6symbolE" + std::to_string(I),
+                                     I % NumMembers));
+  std::string Data = buildArchive(Symbols, NumMembers);
+  ErrorOr<std::unique_ptr<Archive>> ArchiveOrErr =
+      Archive::create(MemoryBufferRef(Data, "test.a"));
+  ASSERT_FALSE(ArchiveOrErr.getError());
+  const Archive &A = **ArchiveOrErr;
+
+  // The first lookup builds the index.
+  TimeRecord Start = TimeRecord::getCurrentTime(true);
+  ASSERT_TRUE(A.findSym(Symbols[0].first) != A.child_end());
+  TimeRecord End = TimeRecord::getCurrentTime(false);
+  outs() << format("first findSym     symbols=%u wall=%.3fs\n", NumSymbols,
+                   End.getWallTime() - Start.getWallTime());
+
+  // Spread the lookups over the whole table, with one miss in eight.
+  std::vector<std::string> Queries;
+  for (unsigned I = 0; I < NumLookups; ++I)
+    Queries.push_back(I % 8 == 7
+                          ? "missing_symbol_" + std::to_string(I)
+                          : Symbols[uint64_t(I) * 7919 % NumSymbols].first);
+
+  unsigned Found = 0;
+  Start = TimeRecord::getCurrentTime(true);
+  for (const std::string &Name : Queries)
+    if (A.findSym(Name) != A.child_end())
+      ++Found;
+  End = TimeRecord::getCurrentTime(false);
+  double Elapsed = End.getWallTime() - Start.getWallTime();
+  EXPECT_EQ(NumLookups - NumLookups / 8, Found);
+  outs() << format("findSym           lookups=%u wall=%.3fs "
+                   "per-lookup=%.1fns\n",
+                   NumLookups, Elapsed, Elapsed * 1e9 / NumLookups);
+
+  Found = 0;
+  Start = TimeRecord::getCurrentTime(true);
+  for (unsigned I = 0; I < NumWalks; ++I)
+    for (auto S = A.symbol_begin(), E = A.symbol_end(); S != E; ++S)
+      if (S->getName() == Queries[I]) {
+        ++Found;
+        break;
+      }
+  End = TimeRecord::getCurrentTime(false);
+  Elapsed = End.getWallTime() - Start.getWallTime();
+  outs() << format("symbol table walk lookups=%u wall=%.3fs "
+                   "per-lookup=%.1fus\n",
+                   NumWalks, Elapsed, Elapsed * 1e6 / NumWalks);
+}
+
+} // end anonymous namespace
@@ -9,6 +9,9 @@
 
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/ProfileData/InstrProfWriter.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 #include <cstdarg>
@@ -85,6 +88,37 @@ TEST_F(InstrProfTest, get_function_counts) {
   ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, EC));
 }
 
+TEST_F(InstrProfTest, get_function_counts_in_place) {
+  Writer.addFunctionCounts("foo", 0x1234, {1, 2});
+  Writer.addFunctionCounts("foo", 0x5678, {3, 4, 5});
+  Writer.addFunctionCounts("a", 0, {6});
+  Writer.addFunctionCounts("abcdefghi", 0, {7});
+  readProfile(Writer.writeBuffer());
+  Reader->setRecordCacheSize(1);
+
+  ArrayRef<uint64_t> Counts;
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x5678, Counts)));
+  ASSERT_EQ(3U, Counts.size());
+  ASSERT_EQ(3U, Counts[0]);
+  ASSERT_EQ(5U, Counts[2]);
+
+  // Keys of different lengths leave the data at different alignments.
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("a", 0, Counts)));
+  ASSERT_EQ(6U, Counts[0]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("abcdefghi", 0, Counts)));
+  ASSERT_EQ(7U, Counts[0]);
+
+  // Lookups that hit and miss the cache agree.
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(1U, Counts[0]);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::hash_mismatch,
+                          Reader->getFunctionCounts("foo", 0, Counts)));
+  ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function,
+                          Reader->getFunctionCounts("bar", 0, Counts)));
+}
+
 TEST_F(InstrProfTest, get_max_function_count) {
   Writer.addFunctionCounts("foo", 0x1234, {1ULL << 31, 2});
   Writer.addFunctionCounts("bar", 0, {1ULL << 63});
@@ -95,4 +129,87 @@ TEST_F(InstrProfTest, get_max_function_count) {
   ASSERT_EQ(1ULL << 63, Reader->getMaximumFunctionCount());
 }
 
+TEST_F(InstrProfTest, merge_writers) {
+  InstrProfWriter Other;
+  Writer.addFunctionCounts("foo", 0x1234, {1, 2});
+  Writer.addFunctionCounts("bar", 0x1234, {1, 2, 3});
+  Other.addFunctionCounts("foo", 0x1234, {3, 4});
+  Other.addFunctionCounts("foo", 0x5678, {1ULL << 40});
+  Other.addFunctionCounts("bar", 0x1234, {1});
+  Other.addFunctionCounts("baz", 0, {5});
+
+  std::vector<std::string> Warnings;
+  Writer.mergeRecordsFromWriter(std::move(Other), [&](StringRef Name,
+                                                      uint64_t Hash,
+                                                      std::error_code EC) {
+    ASSERT_TRUE(ErrorEquals(instrprof_error::count_mismatch, EC));
+    ASSERT_EQ(0x1234U, Hash);
+    Warnings.push_back(Name);
+  });
+  ASSERT_EQ(1U, Warnings.size());
+  ASSERT_EQ("bar", Warnings[0]);
+
+  // The merged-from writer is left empty.
+  auto Empty = Other.writeBuffer();
+  readProfile(std::move(Empty));
+  ASSERT_TRUE(Reader->begin() == Reader->end());
+  ASSERT_EQ(0U, Reader->getMaximumFunctionCount());
+
+  readProfile(Writer.writeBuffer());
+  std::vector<uint64_t> Counts;
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_EQ(4U, Counts[0]);
+  ASSERT_EQ(6U, Counts[1]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x5678, Counts)));
+  ASSERT_EQ(1ULL << 40, Counts[0]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("bar", 0x1234, Counts)));
+  ASSERT_EQ(3U, Counts.size());
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("baz", 0, Counts)));
+  ASSERT_EQ(5U, Counts[0]);
+  ASSERT_EQ(1ULL << 40, Reader->getMaximumFunctionCount());
+}
+
+// Prints the time per lookup with a one and a 16 entry record cache, copying
+// the counts out or reading them in place.
+TEST_F(InstrProfTest, DISABLED_lookup_throughput) {
+  const unsigned NumFunctions = 100000;
+  const unsigned NumLookups = 1000000;
+  std::vector<std::string> Names;
+  for (unsigned I = 0; I < NumFunctions; ++I) {
+    Names.push_back("function_" + std::to_string(I));
+    Writer.addFunctionCounts(Names.back(), I, {I, 1, 2, 3, 4, 5, 6, 7});
+  }
+  readProfile(Writer.writeBuffer());
+
+  for (unsigned CacheSize : {1, 16}) {
+    Reader->setRecordCacheSize(CacheSize);
+    // A lookup pattern with some locality: runs of lookups over a handful of
+    // functions, as when a TU refers to the same inline functions repeatedly.
+    for (bool InPlace : {false, true}) {
+      uint64_t Sum = 0;
+      TimeRecord Start = TimeRecord::getCurrentTime(true);
+      for (unsigned I = 0; I < NumLookups; ++I) {
+        unsigned F = ((I / 64) * 7919 + I % 8) % NumFunctions;
+        if (InPlace) {
+          ArrayRef<uint64_t> Counts;
+          ASSERT_TRUE(NoError(Reader->getFunctionCounts(Names[F], F, Counts)));
+          Sum += Counts[0];
+        } else {
+          std::vector<uint64_t> Counts;
+          ASSERT_TRUE(NoError(Reader->getFunctionCounts(Names[F], F, Counts)));
+          Sum += Counts[0];
+        }
+      }
+      TimeRecord End = TimeRecord::getCurrentTime(false);
+      double Elapsed = End.getWallTime() - Start.getWallTime();
+      outs() << format("cache=%-2u %-8s lookups=%u wall=%.3fs "
+                       "per-lookup=%.1fns (sum %llu)\n",
+                       CacheSize, InPlace ? "in-place" : "copy", NumLookups,
+                       Elapsed, Elapsed * 1e9 / NumLookups,
+                       (unsigned long long)Sum);
+    }
+  }
+}
+
 } // end anonymous namespace
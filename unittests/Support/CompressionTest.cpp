@@ -16,6 +16,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include "gtest/gtest.h"
+#include <string>
 
 using namespace llvm;
 
@@ -59,6 +60,34 @@ TEST(CompressionTest, Zlib) {
   TestZlibCompression(BinaryDataStr, zlib::DefaultCompression);
 }
 
+TEST(CompressionTest, ZlibChunks) {
+  std::string Input;
+  for (unsigned i = 0; i < 100000; ++i)
+    Input += "chunk " + std::to_string(i % 1000) + "\n";
+  StringRef InputStr(Input);
+
+  // Compressing the input in pieces gives the same stream as compressing it
+  // in one go, and appends to what is already in the buffer.
+  SmallString<32> Whole;
+  EXPECT_EQ(zlib::StatusOK, zlib::compress(InputStr, Whole));
+  StringRef Pieces[] = {"", InputStr.substr(0, 1), InputStr.substr(1, 70000),
+                        "", InputStr.substr(70001)};
+  SmallString<32> Chunked("prefix");
+  EXPECT_EQ(zlib::StatusOK, zlib::compress(Pieces, Chunked));
+  EXPECT_EQ("prefix", Chunked.str().substr(0, 6));
+  EXPECT_EQ(Whole.str(), Chunked.str().substr(6));
+
+  SmallString<32> Uncompressed;
+  EXPECT_EQ(zlib::StatusOK, zlib::uncompress(Chunked.str().substr(6),
+                                             Uncompressed, Input.size()));
+  EXPECT_EQ(InputStr, Uncompressed.str());
+
+  SmallString<32> Empty;
+  EXPECT_EQ(zlib::StatusOK, zlib::compress(ArrayRef<StringRef>(), Empty));
+  EXPECT_EQ(zlib::StatusOK, zlib::uncompress(Empty, Uncompressed, 0));
+  EXPECT_TRUE(Uncompressed.empty());
+}
+
 TEST(CompressionTest, ZlibCRC32) {
   EXPECT_EQ(
       0x414FA339U,
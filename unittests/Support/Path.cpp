@@ -538,6 +538,7 @@ TEST_F(FileSystemTest, DirectoryIteration) {
 }
 
 const char archive[] = "!<arch>\x0A";
+const char thin_archive[] = "!<thin>\x0A";
 const char bitcode[] = "\xde\xc0\x17\x0b";
 const char coff_object[] = "\x00\x00......";
 const char coff_bigobj[] = "\x00\x00\xff\xff\x00\x02......"
@@ -572,6 +573,8 @@ TEST_F(FileSystemTest, Magic) {
 #define DEFINE(magic)                                           \
     { #magic, magic, sizeof(magic), fs::file_magic::magic }
     DEFINE(archive),
+    { "thin_archive", thin_archive, sizeof(thin_archive),
+      fs::file_magic::archive },
     DEFINE(bitcode),
     DEFINE(coff_object),
     { "coff_bigobj", coff_bigobj, sizeof(coff_bigobj), fs::file_magic::coff_object },
@@ -9,6 +9,7 @@
 
 #include "llvm/Support/Process.h"
 #include "gtest/gtest.h"
+#include <vector>
 
 #ifdef LLVM_ON_WIN32
 #include <windows.h>
@@ -26,6 +27,31 @@ TEST(ProcessTest, GetRandomNumberTest) {
   EXPECT_NE((r1 | r2), 0u);
 }
 
+TEST(ProcessTest, GetPeakMemoryUsage) {
+  size_t Before = Process::GetPeakMemoryUsage();
+  {
+    // Touch a few megabytes so that they are actually resident.
+    std::vector<char> Buffer(8 << 20, 1);
+    EXPECT_EQ(1, Buffer.back());
+  }
+  size_t After = Process::GetPeakMemoryUsage();
+  // The peak never goes down, and is zero only if unsupported.
+  EXPECT_LE(Before, After);
+  if (After) {
+    EXPECT_LE(size_t(8 << 20), After);
+  }
+}
+
+TEST(ProcessTest, GetResidentMemoryUsage) {
+  size_t Before = Process::GetResidentMemoryUsage();
+  if (!Before)
+    return; // Not supported on this host.
+  std::vector<char> Buffer(8 << 20, 1);
+  EXPECT_EQ(1, Buffer.back());
+  // The buffer is resident now.
+  EXPECT_LE(size_t(8 << 20), Process::GetResidentMemoryUsage());
+}
+
 #ifdef _MSC_VER
 #define setenv(name, var, ignore) _putenv_s(name, var)
 #endif
@@ -0,0 +1,121 @@
+//========- unittests/Support/ThreadPool.cpp - ThreadPool.h tests ---========//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+using namespace llvm;
+
+namespace {
+
+TEST(ThreadPoolTest, AsyncBarrier) {
+  // test that async & barrier work together properly.
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool;
+  for (size_t i = 0; i < 5; ++i) {
+    Pool.async([&checked_in] {
+      ++checked_in;
+    });
+  }
+  Pool.wait();
+  ASSERT_EQ(5, checked_in);
+}
+
+static void TestFunc(std::atomic_int &checked_in, int i) { checked_in += i; }
+
+TEST(ThreadPoolTest, AsyncBarrierArgs) {
+  // Test that async works with a function requiring multiple parameters.
+  std::atomic_int checked_in{0};
+
+  ThreadPool Pool;
+  for (size_t i = 0; i < 5; ++i) {
+    Pool.async(TestFunc, std::ref(checked_in), i);
+  }
+  Pool.wait();
+  ASSERT_EQ(10, checked_in);
+}
+
+TEST(ThreadPoolTest, GetFuture) {
+  ThreadPool Pool(2);
+  std::atomic_int i{0};
+  auto Future = Pool.async([&i] { ++i; });
+  Future.wait();
+  ASSERT_EQ(1, i);
+  Pool.wait();
+}
+
+TEST(ThreadPoolTest, PoolDestruction) {
+  // Test that we are waiting on destruction
+  std::atomic_int checked_in{0};
+  {
+    ThreadPool Pool(3);
+    for (size_t i = 0; i < 5; ++i) {
+      Pool.async([&checked_in] { ++checked_in; });
+    }
+  }
+  ASSERT_EQ(5, checked_in);
+}
+
+TEST(ThreadPoolTest, ZeroThreads) {
+  ThreadPool Pool(0);
+  ASSERT_EQ(1u, Pool.getThreadCount());
+  std::atomic_int checked_in{0};
+  Pool.async([&checked_in] { ++checked_in; });
+  Pool.wait();
+  ASSERT_EQ(1, checked_in);
+}
+
+TEST(ThreadPoolTest, TaskGroups) {
+  // Two groups sharing one pool can each wait for their own tasks.
+  std::atomic_int first{0}, second{0};
+  ThreadPool Pool(2);
+  {
+    ThreadPoolTaskGroup Group1(Pool), Group2(Pool);
+    for (size_t i = 0; i < 10; ++i) {
+      Group1.async([&first] { ++first; });
+      Group2.async([&second] { ++second; });
+    }
+    Group1.wait();
+    ASSERT_EQ(10, first);
+    Group2.wait();
+    ASSERT_EQ(10, second);
+  }
+  Pool.wait();
+}
+
+// Measures how the per-task scheduling overhead scales with the number of
+// threads. This is a benchmark rather than a test, run it explicitly with
+// --gtest_also_run_disabled_tests.
+TEST(ThreadPoolTest, DISABLED_SchedulingOverhead) {
+  const unsigned NumTasks = 100000;
+  for (unsigned Threads = 1; Threads <= 16; Threads *= 2) {
+    std::atomic_int checked_in{0};
+    TimeRecord Start = TimeRecord::getCurrentTime(true);
+    {
+      ThreadPool Pool(Threads);
+      for (unsigned i = 0; i < NumTasks; ++i)
+        Pool.async([&checked_in] { ++checked_in; });
+      Pool.wait();
+    }
+    TimeRecord End = TimeRecord::getCurrentTime(false);
+    ASSERT_EQ((int)NumTasks, checked_in);
+    double Elapsed = End.getWallTime() - Start.getWallTime();
+    outs() << format("threads=%-3u tasks=%u wall=%.3fs per-task=%.3fus\n",
+                     Threads, NumTasks, Elapsed, Elapsed * 1e6 / NumTasks);
+  }
+}
+
+} // end anonymous namespace
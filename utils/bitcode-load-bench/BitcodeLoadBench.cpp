@@ -0,0 +1,104 @@
+//===- BitcodeLoadBench - Benchmark the ways of loading a bitcode file ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program loads a bitcode file either eagerly (parseBitcodeFile), lazily
+// (getLazyBitcodeModule) or lazily with deferred module-level metadata, and
+// reports the wall time and the peak resident set size of the process.
+//
+// The peak RSS of a process never goes down, so each invocation only measures
+// a single mode. Compare modes by running the program several times, e.g.:
+//
+//   for m in eager lazy lazy-metadata; do bitcode-load-bench -mode=$m foo.bc; done
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <system_error>
+
+using namespace llvm;
+
+enum LoadMode { Eager, Lazy, LazyMetadata };
+
+static cl::opt<std::string>
+InputFilename(cl::Positional, cl::desc("<input bitcode>"), cl::Required);
+
+static cl::opt<LoadMode>
+Mode("mode", cl::desc("How to load the bitcode file"), cl::init(Lazy),
+     cl::values(clEnumValN(Eager, "eager", "Read the whole module up front"),
+                clEnumValN(Lazy, "lazy", "Defer reading function bodies"),
+                clEnumValN(LazyMetadata, "lazy-metadata",
+                           "Defer reading function bodies and module-level "
+                           "metadata"),
+                clEnumValEnd));
+
+static cl::opt<bool>
+MaterializeAll("materialize-all",
+               cl::desc("After a lazy load, also time reading the rest of the "
+                        "module"),
+               cl::init(false));
+
+static double getWallTime() {
+  return TimeRecord::getCurrentTime(true).getWallTime();
+}
+
+static void report(StringRef What, double Seconds) {
+  outs() << format("%-16s wall=%.3fs peak-rss=%.1fMB\n", What.str().c_str(),
+                   Seconds,
+                   double(sys::Process::GetPeakMemoryUsage()) / (1 << 20));
+}
+
+int main(int argc, char **argv) {
+  llvm_shutdown_obj Y;
+  cl::ParseCommandLineOptions(argc, argv, "bitcode load benchmark\n");
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+      MemoryBuffer::getFile(InputFilename);
+  if (std::error_code EC = BufferOrErr.getError()) {
+    errs() << InputFilename << ": " << EC.message() << '\n';
+    return 1;
+  }
+  std::unique_ptr<MemoryBuffer> Buffer = std::move(BufferOrErr.get());
+  report("baseline", 0);
+
+  LLVMContext Context;
+  double Start = getWallTime();
+  ErrorOr<Module *> ModuleOrErr =
+      Mode == Eager
+          ? parseBitcodeFile(Buffer->getMemBufferRef(), Context)
+          : getLazyBitcodeModule(MemoryBuffer::getMemBuffer(
+                                     Buffer->getMemBufferRef(), false),
+                                 Context, nullptr, Mode == LazyMetadata);
+  if (std::error_code EC = ModuleOrErr.getError()) {
+    errs() << InputFilename << ": " << EC.message() << '\n';
+    return 1;
+  }
+  std::unique_ptr<Module> M(ModuleOrErr.get());
+  report(Mode == Eager ? "eager" : Mode == Lazy ? "lazy" : "lazy-metadata",
+         getWallTime() - Start);
+
+  if (MaterializeAll && Mode != Eager) {
+    Start = getWallTime();
+    if (std::error_code EC = M->materializeAllPermanently()) {
+      errs() << InputFilename << ": " << EC.message() << '\n';
+      return 1;
+    }
+    report("materialize-all", getWallTime() - Start);
+  }
+
+  return 0;
+}
@@ -0,0 +1,130 @@
+//===- StrTabBench - Benchmark string table construction ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program fills a StringTableBuilder with synthetic mangled C++ names,
+// which share long suffixes the way real symbol tables do, and times
+// finalizing it for a range of table sizes. For comparison it also times the
+// std::sort based suffix sort that finalize used before.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/MC/StringTableBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<unsigned>
+Sizes("sizes", cl::desc("Numbers of strings to build tables of"),
+      cl::CommaSeparated);
+
+static cl::opt<bool>
+NoReference("no-reference",
+            cl::desc("Don't time the std::sort based suffix sort"));
+
+static double getWallTime() {
+  return TimeRecord::getCurrentTime(true).getWallTime();
+}
+
+static void appendSourceName(std::string &Out, const std::string &Name) {
+  Out += std::to_string(Name.size());
+  Out += Name;
+}
+
+// Generates NumStrings distinct names shaped like
+// _ZN<namespace><class><method>E<parameters>.
+static std::vector<std::string> generateNames(unsigned NumStrings) {
+  static const char *const Params[] = {"v", "i", "PKc", "RKS_", "S0_",
+                                       "RKSs", "PvS_", "jj", "RS1_"};
+  std::mt19937 Rand(NumStrings);
+  std::vector<std::string> Names;
+  Names.reserve(NumStrings);
+  for (unsigned I = 0; I < NumStrings; ++I) {
+    std::string Name = "_ZN";
+    appendSourceName(Name, "ns" + std::to_string(Rand() % 32));
+    appendSourceName(Name, "Class" + std::to_string(Rand() % 4096));
+    appendSourceName(Name, "method" + std::to_string(I));
+    Name += 'E';
+    for (unsigned J = 0, E = Rand() % 4 + 1; J < E; ++J)
+      Name += Params[Rand() % array_lengthof(Params)];
+    Names.push_back(std::move(Name));
+  }
+  // Some strings are suffixes of others, as with section names.
+  for (unsigned I = 0; I < NumStrings / 8; ++I)
+    Names.push_back(Names[I].substr(Names[I].size() / 2));
+  return Names;
+}
+
+static bool compareBySuffix(StringRef a, StringRef b) {
+  size_t sizeA = a.size();
+  size_t sizeB = b.size();
+  size_t len = std::min(sizeA, sizeB);
+  for (size_t i = 0; i < len; ++i) {
+    char ca = a[sizeA - i - 1];
+    char cb = b[sizeB - i - 1];
+    if (ca != cb)
+      return ca > cb;
+  }
+  return sizeA > sizeB;
+}
+
+static void runBenchmark(unsigned NumStrings) {
+  std::vector<std::string> Names = generateNames(NumStrings);
+
+  double Start = getWallTime();
+  StringTableBuilder Optimized;
+  for (const std::string &Name : Names)
+    Optimized.add(Name);
+  double AddTime = getWallTime() - Start;
+  Start = getWallTime();
+  Optimized.finalize(StringTableBuilder::ELF);
+  double FinalizeTime = getWallTime() - Start;
+
+  StringTableBuilder InOrder;
+  for (const std::string &Name : Names)
+    InOrder.add(Name);
+  Start = getWallTime();
+  InOrder.finalizeInOrder(StringTableBuilder::ELF);
+  double InOrderTime = getWallTime() - Start;
+
+  outs() << format("strings=%-8u add=%.3fs finalize=%.3fs (%.1fMB) "
+                   "finalizeInOrder=%.3fs (%.1fMB)",
+                   unsigned(Names.size()), AddTime, FinalizeTime,
+                   double(Optimized.data().size()) / (1 << 20), InOrderTime,
+                   double(InOrder.data().size()) / (1 << 20));
+
+  if (!NoReference) {
+    std::vector<StringRef> Refs(Names.begin(), Names.end());
+    Start = getWallTime();
+    std::sort(Refs.begin(), Refs.end(), compareBySuffix);
+    outs() << format(" std::sort=%.3fs", getWallTime() - Start);
+  }
+  outs() << '\n';
+}
+
+int main(int argc, char **argv) {
+  llvm_shutdown_obj Y;
+  cl::ParseCommandLineOptions(argc, argv, "string table benchmark\n");
+
+  if (Sizes.empty()) {
+    for (unsigned N : {10000U, 100000U, 1000000U, 4000000U})
+      runBenchmark(N);
+    return 0;
+  }
+  for (unsigned N : Sizes)
+    runBenchmark(N);
+  return 0;
+}